@@ -0,0 +1,675 @@
+/*
+ Timings behind the figures in Doc.md. Builds the DSP headers from Source/
+ against the stand-ins in JuceStandIns/ and runs the minimum phase filter
+ path the way processChannelGroups does: channels interleaved into SIMD
+ lanes, the chain run in 32-sample control blocks with updateSmoothedFilters
+ in between, and deinterleaved again. "reverb" times FdnReverb on its own
+ and "autogain" adds LoudnessMatch around the filter path, with a check of
+ its gain against a full rate K-weighting.
+
+     cmake -S Benchmarks -B build-bench && cmake --build build-bench
+     build-bench/FilterBenchmarks [smoothing|reverb|autogain|all]
+
+ Results are nanoseconds per sample and channel, the best of several runs,
+ with the cost of copying the input in subtracted.
+ */
+
+#include <JuceHeader.h>
+#include "BiquadCascade.h"
+#include "BandBank.h"
+#include "FdnReverb.h"
+#include "LoudnessMatch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+
+namespace {
+    constexpr int numBands = 16, maxNumChannels = 8, controlBlockSize = 32, blockSize = 512, numBlocks = 1000;
+    constexpr double sampleRate = 48000.0, smoothingTimeSeconds = 0.05;
+
+    template<typename Vector>
+    using FilterChain = juce::dsp::ProcessorChain<BiquadCascade<Vector, 4>, BiquadCascade<Vector, 1>,
+                                                  BiquadCascade<Vector, 4>, BandBank<Vector, numBands>>;
+
+    using FrequencySmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+
+    struct SideSmoothers {
+        FrequencySmoother lowCutFreq, highCutFreq, peakFreq, peakQuality;
+        juce::SmoothedValue<float> peakGain;
+
+        void reset() {
+            for (auto *smoother: {&lowCutFreq, &highCutFreq, &peakFreq, &peakQuality})
+                smoother->reset(sampleRate, smoothingTimeSeconds);
+
+            peakGain.reset(sampleRate, smoothingTimeSeconds);
+        }
+
+        void skipCuts(int numSamples) {
+            lowCutFreq.skip(numSamples);
+            highCutFreq.skip(numSamples);
+        }
+
+        void skipPeak(int numSamples) {
+            peakFreq.skip(numSamples);
+            peakQuality.skip(numSamples);
+            peakGain.skip(numSamples);
+        }
+
+        bool isPeakSmoothing() const {
+            return peakFreq.isSmoothing() || peakQuality.isSmoothing() || peakGain.isSmoothing();
+        }
+    };
+
+    struct BandSmoothers {
+        FrequencySmoother freq, quality;
+        juce::SmoothedValue<float> gain;
+    };
+
+    enum class Ramp {
+        none,
+        peak,
+        peakAndCuts
+    };
+
+    /**
+     The processor's filter path for one precision: as many chains as
+     ChannelGroups holds for maxNumChannels, the smoothers of both sides and
+     the bands, and updateSmoothedFilters without the LFO and the dynamic peak.
+     */
+    template<typename SampleType>
+    class Engine {
+    public:
+        using Vector = juce::dsp::SIMDRegister<SampleType>;
+        static constexpr int numLanes = (int) Vector::size();
+        static constexpr int maxGroups = (maxNumChannels + numLanes - 1) / numLanes;
+
+        Engine(int numChannelsToUse, int numActiveBands, int cutRedesignTicksToUse)
+            : numChannels(numChannelsToUse), numGroups((numChannelsToUse + numLanes - 1) / numLanes),
+              cutRedesignTicks(cutRedesignTicksToUse) {
+            interleaved = juce::dsp::AudioBlock<Vector>(interleavedStorage, (size_t) maxGroups, (size_t) blockSize);
+
+            for (auto &side: sides) {
+                side.reset();
+                side.lowCutFreq.setCurrentAndTargetValue(80.0f);
+                side.highCutFreq.setCurrentAndTargetValue(16000.0f);
+                side.peakFreq.setCurrentAndTargetValue(1000.0f);
+                side.peakQuality.setCurrentAndTargetValue(1.0f);
+                side.peakGain.setCurrentAndTargetValue(6.0f);
+            }
+
+            for (auto &band: bandSmoothers) {
+                band.freq.reset(sampleRate, smoothingTimeSeconds);
+                band.quality.reset(sampleRate, smoothingTimeSeconds);
+                band.gain.reset(sampleRate, smoothingTimeSeconds);
+                band.freq.setCurrentAndTargetValue(500.0f);
+                band.quality.setCurrentAndTargetValue(1.0f);
+            }
+
+            for (auto &chain: chains) {
+                chain.prepare({sampleRate, (juce::uint32) blockSize, 1});
+
+                for (int i = 0; i < numActiveBands; ++i)
+                    chain.template get<3>().setBand(i, makePeakCoefficients(sampleRate, 200.0 * (i + 1), 1.0, 1.4),
+                                                    true);
+            }
+
+            updateLowCut<PreciseMath>();
+            updateHighCut<PreciseMath>();
+            updatePeak<PreciseMath>();
+        }
+
+        std::array<SideSmoothers, 2> sides;
+
+        void process(juce::AudioBuffer<SampleType> &buffer) {
+            const auto numSamples = buffer.getNumSamples();
+
+            interleave(buffer, numSamples);
+
+            for (int start = 0; start < numSamples;) {
+                if (samplesUntilControlTick == 0) {
+                    samplesUntilControlTick = controlBlockSize;
+                    updateSmoothedFilters(controlBlockSize);
+                }
+
+                const auto num = std::min(samplesUntilControlTick, numSamples - start);
+
+                for (int group = 0; group < numGroups; ++group) {
+                    auto block = interleaved.getSingleChannelBlock((size_t) group)
+                            .getSubBlock((size_t) start, (size_t) num);
+                    chains[(size_t) group].process(juce::dsp::ProcessContextReplacing<Vector>(block));
+                }
+
+                samplesUntilControlTick -= num;
+                start += num;
+            }
+
+            deinterleave(buffer, numSamples);
+        }
+
+    private:
+        int numChannels, numGroups, cutRedesignTicks;
+        int samplesUntilControlTick = 0, cutTicksUntilRedesign = 0, cutSamplesPending = 0;
+
+        std::array<FilterChain<Vector>, maxGroups> chains;
+        juce::HeapBlock<char> interleavedStorage;
+        juce::dsp::AudioBlock<Vector> interleaved;
+
+        std::array<BandSmoothers, numBands> bandSmoothers;
+
+        void interleave(const juce::AudioBuffer<SampleType> &buffer, int numSamples) {
+            for (int group = 0; group < numGroups; ++group) {
+                auto *frames = reinterpret_cast<SampleType *>(interleaved.getChannelPointer((size_t) group));
+
+                for (int lane = 0; lane < numLanes; ++lane) {
+                    const auto channel = group * numLanes + lane;
+
+                    if (channel < numChannels) {
+                        const auto *source = buffer.getReadPointer(channel);
+                        for (int i = 0; i < numSamples; ++i)
+                            frames[i * numLanes + lane] = source[i];
+                    } else {
+                        for (int i = 0; i < numSamples; ++i)
+                            frames[i * numLanes + lane] = SampleType(0);
+                    }
+                }
+            }
+        }
+
+        void deinterleave(juce::AudioBuffer<SampleType> &buffer, int numSamples) {
+            for (int channel = 0; channel < numChannels; ++channel) {
+                const auto *frames = reinterpret_cast<const SampleType *>(
+                    interleaved.getChannelPointer((size_t) (channel / numLanes)));
+                const auto lane = channel % numLanes;
+                auto *destination = buffer.getWritePointer(channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                    destination[i] = frames[i * numLanes + lane];
+            }
+        }
+
+        // 24 dB/oct cuts and the peak, designed as updateLowCutFilter and
+        // friends do and applied to every chain
+        template<typename Math>
+        void updateLowCut() {
+            const auto coefficients = designButterworthHighPass<4, Math>(sides[0].lowCutFreq.getCurrentValue(),
+                                                                         sampleRate, 4);
+            for (auto &chain: chains) {
+                for (int i = 0; i < 2; ++i)
+                    chain.template get<0>().setSection(i, coefficients[i]);
+
+                chain.template get<0>().setNumActiveStages(2);
+            }
+        }
+
+        template<typename Math>
+        void updateHighCut() {
+            const auto coefficients = designButterworthLowPass<4, Math>(sides[0].highCutFreq.getCurrentValue(),
+                                                                        sampleRate, 4);
+            for (auto &chain: chains) {
+                for (int i = 0; i < 2; ++i)
+                    chain.template get<2>().setSection(i, coefficients[i]);
+
+                chain.template get<2>().setNumActiveStages(2);
+            }
+        }
+
+        template<typename Math>
+        void updatePeak() {
+            const auto coefficients = makePeakCoefficients<Math>(sampleRate, sides[0].peakFreq.getCurrentValue(),
+                                                                 sides[0].peakQuality.getCurrentValue(),
+                                                                 juce::Decibels::decibelsToGain(
+                                                                     (double) sides[0].peakGain.getCurrentValue()));
+            for (auto &chain: chains) {
+                chain.template get<1>().setSection(0, coefficients);
+                chain.template get<1>().setNumActiveStages(1);
+            }
+        }
+
+        void updateSmoothedFilters(int numSamples) {
+            const auto lowCutRamping = sides[0].lowCutFreq.isSmoothing() || sides[1].lowCutFreq.isSmoothing();
+            const auto highCutRamping = sides[0].highCutFreq.isSmoothing() || sides[1].highCutFreq.isSmoothing();
+            const auto peakMoving = sides[0].isPeakSmoothing() || sides[1].isPeakSmoothing();
+
+            std::array<bool, numBands> bandMoving{};
+            for (size_t i = 0; i < (size_t) numBands; ++i)
+                bandMoving[i] = bandSmoothers[i].freq.isSmoothing()
+                                || bandSmoothers[i].quality.isSmoothing()
+                                || bandSmoothers[i].gain.isSmoothing();
+
+            const auto anyBandMoving = std::find(bandMoving.begin(), bandMoving.end(), true) != bandMoving.end();
+
+            if (!lowCutRamping && !highCutRamping) {
+                cutTicksUntilRedesign = 0;
+                cutSamplesPending = 0;
+            }
+
+            if (!lowCutRamping && !highCutRamping && !peakMoving && !anyBandMoving)
+                return;
+
+            cutSamplesPending += numSamples;
+
+            const auto cutTick = --cutTicksUntilRedesign <= 0;
+            if (cutTick) {
+                cutTicksUntilRedesign = cutRedesignTicks;
+
+                for (auto &side: sides)
+                    side.skipCuts(cutSamplesPending);
+
+                cutSamplesPending = 0;
+            }
+
+            for (auto &side: sides)
+                side.skipPeak(numSamples);
+
+            for (auto &band: bandSmoothers) {
+                band.freq.skip(numSamples);
+                band.quality.skip(numSamples);
+                band.gain.skip(numSamples);
+            }
+
+            if (lowCutRamping && cutTick)
+                updateLowCut<FastMath>();
+
+            if (highCutRamping && cutTick)
+                updateHighCut<FastMath>();
+
+            if (peakMoving)
+                updatePeak<FastMath>();
+        }
+    };
+
+    template<typename SampleType>
+    std::vector<juce::AudioBuffer<SampleType>> makeNoise(int numChannels) {
+        std::mt19937 random(1);
+        std::normal_distribution<double> noise(0.0, 0.1);
+        std::vector<juce::AudioBuffer<SampleType>> blocks(8, juce::AudioBuffer<SampleType>(numChannels, blockSize));
+
+        for (auto &block: blocks)
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    block.getWritePointer(channel)[i] = (SampleType) noise(random);
+
+        return blocks;
+    }
+
+    template<typename SampleType>
+    void copyIn(const juce::AudioBuffer<SampleType> &source, juce::AudioBuffer<SampleType> &destination) {
+        for (int channel = 0; channel < source.getNumChannels(); ++channel)
+            std::copy(source.getReadPointer(channel), source.getReadPointer(channel) + blockSize,
+                      destination.getWritePointer(channel));
+    }
+
+    /**
+     Runs each case over numBlocks blocks, taking turns so slow phases of the
+     machine hit every case alike, and returns the best time of each per
+     sample and channel.
+     */
+    std::vector<double> timeBlocks(int numChannels, const std::vector<std::function<void(int)>> &cases) {
+        std::vector<double> best(cases.size(), 1.0e30);
+
+        for (int run = 0; run < 25; ++run) {
+            for (size_t i = 0; i < cases.size(); ++i) {
+                const auto start = std::chrono::steady_clock::now();
+
+                for (int k = 0; k < numBlocks; ++k)
+                    cases[i](k);
+
+                const auto elapsed = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start);
+                best[i] = std::min(best[i], elapsed.count() / ((double) numBlocks * blockSize * numChannels));
+            }
+        }
+
+        return best;
+    }
+
+    struct Options {
+        int numActiveBands = 0;
+        Ramp ramp = Ramp::none;
+        int cutRedesignTicks = 4;
+    };
+
+    /** One engine with its input, processing a block per call; the first case only copies the input in. */
+    template<typename SampleType>
+    class Case {
+    public:
+        Case(int numChannels, const Options &options)
+            : engine(numChannels, options.numActiveBands, options.cutRedesignTicks), ramp(options.ramp),
+              input(makeNoise<SampleType>(numChannels)), buffer(numChannels, blockSize) {}
+
+        void processBlock(int k) {
+            // new targets every 8 blocks, so the 50 ms ramps never settle
+            if (ramp != Ramp::none) {
+                const auto up = (k / 8) % 2 == 0;
+
+                for (auto &side: engine.sides) {
+                    side.peakFreq.setTargetValue(up ? 2000.0f : 500.0f);
+                    side.peakGain.setTargetValue(up ? 9.0f : 3.0f);
+
+                    if (ramp == Ramp::peakAndCuts) {
+                        side.lowCutFreq.setTargetValue(up ? 200.0f : 50.0f);
+                        side.highCutFreq.setTargetValue(up ? 12000.0f : 18000.0f);
+                    }
+                }
+            }
+
+            copyIn(input[(size_t) k % input.size()], buffer);
+            engine.process(buffer);
+        }
+
+        void copyOnly(int k) {
+            copyIn(input[(size_t) k % input.size()], buffer);
+            sink = sink + buffer.getReadPointer(0)[k % blockSize];
+        }
+
+    private:
+        Engine<SampleType> engine;
+        Ramp ramp;
+        std::vector<juce::AudioBuffer<SampleType>> input;
+        juce::AudioBuffer<SampleType> buffer;
+        volatile SampleType sink = 0;
+    };
+
+    /** The time of each options set, with the time of copying the input in subtracted. */
+    template<typename SampleType>
+    std::vector<double> measure(int numChannels, const std::vector<Options> &optionSets) {
+        std::vector<std::unique_ptr<Case<SampleType>>> cases;
+        std::vector<std::function<void(int)>> bodies;
+
+        for (const auto &options: optionSets)
+            cases.push_back(std::make_unique<Case<SampleType>>(numChannels, options));
+
+        bodies.push_back([&cases](int k) { cases.front()->copyOnly(k); });
+
+        for (auto &c: cases)
+            bodies.push_back([&c](int k) { c->processBlock(k); });
+
+        auto times = timeBlocks(numChannels, bodies);
+        const auto copyTime = times.front();
+        times.erase(times.begin());
+
+        for (auto &time: times)
+            time -= copyTime;
+
+        return times;
+    }
+
+    void printRow(const char *name, double nanoseconds, double baseline) {
+        std::printf("  %-48s %6.2f ns  %+6.1f%%\n", name, nanoseconds, 100.0 * (nanoseconds - baseline) / baseline);
+    }
+
+    void benchmarkSmoothing() {
+        std::printf("smoothing (float, stereo):\n");
+
+        for (const auto numActiveBands: {0, 4}) {
+            std::printf(" %d bands active\n", numActiveBands);
+
+            const auto times = measure<float>(2, {
+                                                  {numActiveBands, Ramp::none},
+                                                  {numActiveBands, Ramp::peak},
+                                                  {numActiveBands, Ramp::peakAndCuts, 1},
+                                                  {numActiveBands, Ramp::peakAndCuts, 4}
+                                              });
+
+            printRow("nothing ramping", times[0], times[0]);
+            printRow("peak ramping", times[1], times[0]);
+            printRow("peak and both cuts ramping, cuts every tick", times[2], times[0]);
+            printRow("peak and both cuts ramping, cuts every 4 ticks", times[3], times[0]);
+        }
+    }
+
+    /** FdnReverb on one stereo pair, natively or, for double, through a float buffer like processInFloat. */
+    template<typename SampleType, bool convertToFloat = false>
+    class ReverbCase {
+    public:
+        using ReverbType = std::conditional_t<convertToFloat, float, SampleType>;
+
+        explicit ReverbCase(bool halfRate) : input(makeNoise<SampleType>(2)), buffer(2, blockSize), scratch(2, blockSize) {
+            juce::dsp::Reverb::Parameters parameters;
+            parameters.roomSize = 0.8f;
+            parameters.wetLevel = 0.5f;
+
+            reverb.prepare({sampleRate, (juce::uint32) blockSize, 2});
+            reverb.setParameters(parameters);
+            reverb.setHalfRate(halfRate);
+        }
+
+        void processBlock(int k) {
+            copyIn(input[(size_t) k % input.size()], buffer);
+
+            if constexpr (convertToFloat) {
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = 0; i < blockSize; ++i)
+                        scratch.getWritePointer(channel)[i] = (float) buffer.getReadPointer(channel)[i];
+
+                process(scratch);
+
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = 0; i < blockSize; ++i)
+                        buffer.getWritePointer(channel)[i] = (SampleType) scratch.getReadPointer(channel)[i];
+            } else {
+                process(buffer);
+            }
+        }
+
+        void copyOnly(int k) {
+            copyIn(input[(size_t) k % input.size()], buffer);
+            sink = sink + buffer.getReadPointer(0)[k % blockSize];
+        }
+
+    private:
+        template<typename Type>
+        void process(juce::AudioBuffer<Type> &target) {
+            Type *channels[] = {target.getWritePointer(0), target.getWritePointer(1)};
+            juce::dsp::AudioBlock<Type> block(channels, 2, (size_t) blockSize);
+            reverb.process(juce::dsp::ProcessContextReplacing<Type>(block));
+        }
+
+        FdnReverb<ReverbType> reverb;
+        std::vector<juce::AudioBuffer<SampleType>> input;
+        juce::AudioBuffer<SampleType> buffer;
+        juce::AudioBuffer<float> scratch;
+        volatile SampleType sink = 0;
+    };
+
+    void benchmarkReverb() {
+        std::printf("FDN reverb (stereo):\n");
+
+        for (const auto halfRate: {false, true}) {
+            std::printf(" %s rate\n", halfRate ? "half" : "full");
+
+            ReverbCase<float> floatCase(halfRate);
+            ReverbCase<double> doubleCase(halfRate);
+            ReverbCase<double, true> convertedCase(halfRate);
+
+            auto times = timeBlocks(2, {
+                                        [&](int k) { floatCase.copyOnly(k); },
+                                        [&](int k) { doubleCase.copyOnly(k); },
+                                        [&](int k) { floatCase.processBlock(k); },
+                                        [&](int k) { doubleCase.processBlock(k); },
+                                        [&](int k) { convertedCase.processBlock(k); }
+                                    });
+
+            times[2] -= times[0];
+            times[3] -= times[1];
+            times[4] -= times[1];
+
+            printRow("float", times[2], times[2]);
+            printRow("double", times[3], times[2]);
+            printRow("double through a float buffer", times[4], times[2]);
+        }
+    }
+
+    /** The filter path with, optionally, the auto gain around it as processSamples and applyAutoGain run it. */
+    class AutoGainCase {
+    public:
+        AutoGainCase(int numChannelsToUse, bool useAutoGain)
+            : numChannels(numChannelsToUse), autoGain(useAutoGain), engine(numChannelsToUse, 0, 4),
+              input(makeNoise<float>(numChannelsToUse)), buffer(numChannelsToUse, blockSize) {
+            loudnessMatch.prepare(sampleRate, blockSize);
+            autoGainSmoother.reset(sampleRate, 0.2);
+            autoGainSmoother.setCurrentAndTargetValue(1.0f);
+        }
+
+        void processBlock(int k) {
+            copyIn(input[(size_t) k % input.size()], buffer);
+
+            if (autoGain)
+                loudnessMatch.pushInput(buffer, numChannels, blockSize);
+
+            engine.process(buffer);
+
+            if (!autoGain)
+                return;
+
+            loudnessMatch.pushOutput(buffer, numChannels, blockSize);
+            autoGainSmoother.setTargetValue(juce::Decibels::decibelsToGain(loudnessMatch.getGainDecibels()));
+
+            const auto startGain = autoGainSmoother.getCurrentValue();
+            autoGainSmoother.skip(blockSize);
+            const auto endGain = autoGainSmoother.getCurrentValue();
+
+            if (startGain != 1.0f || endGain != 1.0f)
+                for (int channel = 0; channel < numChannels; ++channel)
+                    buffer.applyGainRamp(channel, 0, blockSize, startGain, endGain);
+        }
+
+        void copyOnly(int k) {
+            copyIn(input[(size_t) k % input.size()], buffer);
+            sink = sink + buffer.getReadPointer(0)[k % blockSize];
+        }
+
+    private:
+        int numChannels;
+        bool autoGain;
+        Engine<float> engine;
+        LoudnessMatch<maxNumChannels> loudnessMatch;
+        juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> autoGainSmoother;
+        std::vector<juce::AudioBuffer<float>> input;
+        juce::AudioBuffer<float> buffer;
+        volatile float sink = 0;
+    };
+
+    /** Direct form I in double, for the reference measurement. */
+    struct ReferenceBiquad {
+        BiquadCoefficients c;
+        double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+        double process(double x) {
+            const auto y = c.b0 * x + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2;
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+            return y;
+        }
+    };
+
+    /** Mean square of a signal K-weighted at the full rate, skipping the first second. */
+    double referencePower(const std::vector<double> &signal) {
+        ReferenceBiquad shelf{makeKWeightingShelfCoefficients(sampleRate)};
+        ReferenceBiquad highPass{makeKWeightingHighPassCoefficients(sampleRate)};
+        const auto skip = (size_t) sampleRate;
+        double sum = 0.0;
+
+        for (size_t i = 0; i < signal.size(); ++i) {
+            const auto weighted = highPass.process(shelf.process(signal[i]));
+            if (i >= skip)
+                sum += weighted * weighted;
+        }
+
+        return sum / (double) (signal.size() - skip);
+    }
+
+    /**
+     The gain LoudnessMatch settles on for white noise against the same noise
+     through the given sections, minus the gain from a full rate K-weighting in
+     double.
+     */
+    double gainError(const std::vector<BiquadCoefficients> &sections) {
+        const auto numSamples = blockSize * (int) (6.0 * sampleRate / blockSize);
+        std::mt19937 random(2);
+        std::normal_distribution<double> noise(0.0, 0.1);
+        std::vector<double> in((size_t) numSamples), out((size_t) numSamples);
+
+        for (auto &sample: in)
+            sample = noise(random);
+
+        std::vector<ReferenceBiquad> filters;
+        for (const auto &section: sections)
+            filters.push_back({section});
+
+        for (size_t i = 0; i < in.size(); ++i) {
+            auto sample = in[i];
+            for (auto &filter: filters)
+                sample = filter.process(sample);
+
+            out[i] = sample;
+        }
+
+        LoudnessMatch<maxNumChannels> loudnessMatch;
+        loudnessMatch.prepare(sampleRate, blockSize);
+        juce::AudioBuffer<float> inBlock(1, blockSize), outBlock(1, blockSize);
+
+        for (int start = 0; start < numSamples; start += blockSize) {
+            for (int i = 0; i < blockSize; ++i) {
+                inBlock.getWritePointer(0)[i] = (float) in[(size_t) (start + i)];
+                outBlock.getWritePointer(0)[i] = (float) out[(size_t) (start + i)];
+            }
+
+            loudnessMatch.pushInput(inBlock, 1, blockSize);
+            loudnessMatch.pushOutput(outBlock, 1, blockSize);
+        }
+
+        const auto reference = 10.0 * std::log10(referencePower(in) / referencePower(out));
+        return loudnessMatch.getGainDecibels() - reference;
+    }
+
+    void benchmarkAutoGain() {
+        std::printf("auto gain (float, low cut, peak and high cut):\n");
+
+        for (const auto numChannels: {2, 8}) {
+            AutoGainCase off(numChannels, false), on(numChannels, true);
+
+            auto times = timeBlocks(numChannels, {
+                                        [&](int k) { off.copyOnly(k); },
+                                        [&](int k) { off.processBlock(k); },
+                                        [&](int k) { on.processBlock(k); }
+                                    });
+
+            std::printf(" %d channels\n", numChannels);
+            printRow("auto gain off", times[1] - times[0], times[1] - times[0]);
+            printRow("auto gain on", times[2] - times[0], times[1] - times[0]);
+        }
+
+        std::printf(" gain error against full rate K-weighting, white noise:\n");
+
+        const auto lowCut = designButterworthHighPass<4>(150.0, sampleRate, 4);
+        const auto highCut = designButterworthLowPass<4>(3000.0, sampleRate, 4);
+        const auto highCut8k = designButterworthLowPass<4>(8000.0, sampleRate, 4);
+
+        std::printf("  %-48s %+6.3f dB\n", "low cut 150 Hz", gainError({lowCut[0], lowCut[1]}));
+        std::printf("  %-48s %+6.3f dB\n", "high cut 3 kHz", gainError({highCut[0], highCut[1]}));
+        std::printf("  %-48s %+6.3f dB\n", "high cut 8 kHz", gainError({highCut8k[0], highCut8k[1]}));
+        std::printf("  %-48s %+6.3f dB\n", "peak 10 kHz +12 dB",
+                    gainError({makePeakCoefficients(sampleRate, 10000.0, 1.0, 4.0)}));
+    }
+}
+
+int main(int argc, char **argv) {
+    const std::string which = argc > 1 ? argv[1] : "all";
+
+    if (which == "all" || which == "smoothing")
+        benchmarkSmoothing();
+
+    if (which == "all" || which == "reverb")
+        benchmarkReverb();
+
+    if (which == "all" || which == "autogain")
+        benchmarkAutoGain();
+
+    return 0;
+}
@@ -0,0 +1,449 @@
+#pragma once
+
+/*
+ Just enough of JUCE for the DSP headers in Source/ to compile on their own,
+ so the benchmarks build without the JUCE modules. Only what the timed code
+ calls is here, with the same semantics as JUCE but none of its checks.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#define jassert(expression) ((void) 0)
+#define jassertfalse ((void) 0)
+#define JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(className)
+
+namespace juce {
+    using uint32 = unsigned int;
+
+    template<typename... Types>
+    void ignoreUnused(Types &&...) {}
+
+    template<typename Type, typename Upper>
+    bool isPositiveAndBelow(Type value, Upper upper) { return value >= Type(0) && value < (Type) upper; }
+
+    template<typename Type>
+    struct MathConstants {
+        static constexpr Type pi = (Type) 3.141592653589793238;
+        static constexpr Type twoPi = (Type) 2 * pi;
+        static constexpr Type halfPi = pi / (Type) 2;
+        static constexpr Type sqrt2 = (Type) 1.4142135623730951;
+    };
+
+    template<typename Type>
+    Type jlimit(Type lower, Type upper, Type value) { return value < lower ? lower : (value > upper ? upper : value); }
+
+    template<typename Type>
+    Type jmin(Type a, Type b) { return a < b ? a : b; }
+
+    template<typename Type>
+    Type jmax(Type a, Type b) { return a < b ? b : a; }
+
+    template<typename Type>
+    Type jmap(Type proportion, Type start, Type end) { return start + proportion * (end - start); }
+
+    template<typename Type>
+    int roundToInt(Type value) { return (int) std::lround(value); }
+
+    struct Decibels {
+        template<typename Type>
+        static Type decibelsToGain(Type decibels, Type minusInfinityDb = Type(-100)) {
+            return decibels > minusInfinityDb ? std::pow(Type(10), decibels / Type(20)) : Type(0);
+        }
+
+        template<typename Type>
+        static Type gainToDecibels(Type gain, Type minusInfinityDb = Type(-100)) {
+            return gain > Type(0) ? std::max(minusInfinityDb, Type(20) * std::log10(gain)) : minusInfinityDb;
+        }
+    };
+
+    /** 64-byte aligned, like the storage SIMD blocks get in JUCE. */
+    template<typename Type>
+    class HeapBlock {
+    public:
+        HeapBlock() = default;
+
+        HeapBlock(const HeapBlock &) = delete;
+
+        ~HeapBlock() { std::free(data); }
+
+        void malloc(size_t numElements) {
+            std::free(data);
+            data = static_cast<Type *>(std::aligned_alloc(64, ((numElements * sizeof(Type) + 63) / 64) * 64));
+        }
+
+        Type *get() const { return data; }
+
+        operator Type *() const { return data; }
+
+    private:
+        Type *data = nullptr;
+    };
+
+    template<typename Type>
+    class AudioBuffer {
+    public:
+        AudioBuffer() = default;
+
+        AudioBuffer(int numChannels, int numSamples) { setSize(numChannels, numSamples); }
+
+        void setSize(int numChannels, int numSamplesToUse) {
+            channels.assign((size_t) numChannels, std::vector<Type>((size_t) numSamplesToUse));
+            numSamples = numSamplesToUse;
+        }
+
+        int getNumChannels() const { return (int) channels.size(); }
+
+        int getNumSamples() const { return numSamples; }
+
+        const Type *getReadPointer(int channel) const { return channels[(size_t) channel].data(); }
+
+        const Type *getReadPointer(int channel, int sample) const { return getReadPointer(channel) + sample; }
+
+        Type *getWritePointer(int channel) { return channels[(size_t) channel].data(); }
+
+        Type *getWritePointer(int channel, int sample) { return getWritePointer(channel) + sample; }
+
+        void clear() {
+            for (auto &channel: channels)
+                std::fill(channel.begin(), channel.end(), Type(0));
+        }
+
+        void applyGainRamp(int channel, int startSample, int num, Type startGain, Type endGain) {
+            auto *samples = getWritePointer(channel, startSample);
+            const auto increment = (endGain - startGain) / (Type) num;
+
+            for (int i = 0; i < num; ++i) {
+                samples[i] *= startGain;
+                startGain += increment;
+            }
+        }
+
+    private:
+        std::vector<std::vector<Type>> channels;
+        int numSamples = 0;
+    };
+
+    namespace ValueSmoothingTypes {
+        struct Linear {};
+
+        struct Multiplicative {};
+    }
+
+    template<typename Type, typename SmoothingType = ValueSmoothingTypes::Linear>
+    class SmoothedValue {
+    public:
+        void reset(double sampleRate, double rampLengthInSeconds) {
+            stepsToTarget = (int) std::floor(rampLengthInSeconds * sampleRate);
+            setCurrentAndTargetValue(target);
+        }
+
+        void setCurrentAndTargetValue(Type newValue) {
+            current = target = newValue;
+            countdown = 0;
+        }
+
+        void setTargetValue(Type newValue) {
+            if (newValue == target)
+                return;
+
+            if (stepsToTarget <= 0) {
+                setCurrentAndTargetValue(newValue);
+                return;
+            }
+
+            target = newValue;
+            countdown = stepsToTarget;
+
+            if constexpr (multiplicative)
+                step = std::exp((std::log(std::abs(target)) - std::log(std::abs(current))) / (Type) countdown);
+            else
+                step = (target - current) / (Type) countdown;
+        }
+
+        bool isSmoothing() const { return countdown > 0; }
+
+        Type getCurrentValue() const { return current; }
+
+        Type getTargetValue() const { return target; }
+
+        Type getNextValue() {
+            if (!isSmoothing())
+                return target;
+
+            --countdown;
+
+            if (!isSmoothing())
+                current = target;
+            else if constexpr (multiplicative)
+                current *= step;
+            else
+                current += step;
+
+            return current;
+        }
+
+        Type skip(int numSamples) {
+            if (numSamples >= countdown) {
+                setCurrentAndTargetValue(target);
+                return target;
+            }
+
+            if constexpr (multiplicative)
+                current *= std::pow(step, (Type) numSamples);
+            else
+                current += step * (Type) numSamples;
+
+            countdown -= numSamples;
+            return current;
+        }
+
+    private:
+        static constexpr bool multiplicative = std::is_same_v<SmoothingType, ValueSmoothingTypes::Multiplicative>;
+
+        Type current{}, target{}, step{};
+        int countdown = 0, stepsToTarget = 0;
+    };
+
+    namespace dsp {
+        struct ProcessSpec {
+            double sampleRate;
+            uint32 maximumBlockSize;
+            uint32 numChannels;
+        };
+
+        /** One SSE register, as JUCE uses on x86. */
+        template<typename Type>
+        struct SIMDRegister {
+            using ElementType = Type;
+            typedef Type NativeType __attribute__((vector_size(16)));
+
+            NativeType value;
+
+            static constexpr size_t SIMDRegisterSize = 16;
+            static constexpr size_t SIMDNumElements = SIMDRegisterSize / sizeof(Type);
+
+            static constexpr size_t size() { return SIMDNumElements; }
+
+            static SIMDRegister expand(Type scalar) { return {scalar - NativeType{}}; }
+
+            static SIMDRegister fromRawArray(const Type *source) {
+                SIMDRegister result;
+                std::memcpy(&result.value, source, SIMDRegisterSize);
+                return result;
+            }
+
+            void copyToRawArray(Type *destination) const { std::memcpy(destination, &value, SIMDRegisterSize); }
+
+            void set(size_t index, Type scalar) { value[index] = scalar; }
+
+            Type get(size_t index) const { return value[index]; }
+
+            Type sum() const {
+                Type result = 0;
+                for (size_t i = 0; i < size(); ++i)
+                    result += value[i];
+
+                return result;
+            }
+
+            SIMDRegister operator+(SIMDRegister other) const { return {value + other.value}; }
+            SIMDRegister operator-(SIMDRegister other) const { return {value - other.value}; }
+            SIMDRegister operator*(SIMDRegister other) const { return {value * other.value}; }
+            SIMDRegister operator+(Type scalar) const { return {value + scalar}; }
+            SIMDRegister operator-(Type scalar) const { return {value - scalar}; }
+            SIMDRegister operator*(Type scalar) const { return {value * scalar}; }
+            SIMDRegister operator-() const { return {-value}; }
+
+            SIMDRegister &operator+=(SIMDRegister other) { value += other.value; return *this; }
+            SIMDRegister &operator-=(SIMDRegister other) { value -= other.value; return *this; }
+            SIMDRegister &operator*=(SIMDRegister other) { value *= other.value; return *this; }
+            SIMDRegister &operator+=(Type scalar) { value += scalar; return *this; }
+            SIMDRegister &operator*=(Type scalar) { value *= scalar; return *this; }
+
+            explicit operator bool() const = delete;
+        };
+
+        struct Reverb {
+            struct Parameters {
+                float roomSize = 0.5f, damping = 0.5f, wetLevel = 0.33f, dryLevel = 0.4f, width = 1.0f,
+                        freezeMode = 0.0f;
+            };
+        };
+
+        namespace util {
+            template<typename Type>
+            void snapToZero(Type &value) {
+                if constexpr (std::is_floating_point_v<Type>)
+                    if (!(value < Type(-1.0e-8) || value > Type(1.0e-8)))
+                        value = 0;
+            }
+        }
+
+        template<typename Type>
+        class AudioBlock {
+        public:
+            AudioBlock() = default;
+
+            AudioBlock(HeapBlock<char> &storage, size_t numChannelsToUse, size_t numSamplesToUse)
+                : numChannels(numChannelsToUse), numSamples(numSamplesToUse) {
+                storage.malloc(numChannels * numSamples * sizeof(Type));
+
+                for (size_t i = 0; i < numChannels; ++i)
+                    channels[i] = reinterpret_cast<Type *>(storage.get()) + i * numSamples;
+            }
+
+            AudioBlock(Type *const *channelData, size_t numChannelsToUse, size_t numSamplesToUse)
+                : numChannels(numChannelsToUse), numSamples(numSamplesToUse) {
+                for (size_t i = 0; i < numChannels; ++i)
+                    channels[i] = channelData[i];
+            }
+
+            size_t getNumChannels() const { return numChannels; }
+
+            size_t getNumSamples() const { return numSamples; }
+
+            Type *getChannelPointer(size_t channel) const { return channels[channel]; }
+
+            AudioBlock getSingleChannelBlock(size_t channel) const { return getSubsetChannelBlock(channel, 1); }
+
+            AudioBlock getSubsetChannelBlock(size_t firstChannel, size_t num) const {
+                AudioBlock result;
+                result.numChannels = num;
+                result.numSamples = numSamples;
+
+                for (size_t i = 0; i < num; ++i)
+                    result.channels[i] = channels[firstChannel + i];
+
+                return result;
+            }
+
+            AudioBlock getSubBlock(size_t start, size_t length) const {
+                auto result = *this;
+                result.numSamples = length;
+
+                for (size_t i = 0; i < numChannels; ++i)
+                    result.channels[i] += start;
+
+                return result;
+            }
+
+            AudioBlock &clear() {
+                for (size_t i = 0; i < numChannels; ++i)
+                    std::memset(static_cast<void *>(channels[i]), 0, numSamples * sizeof(Type));
+
+                return *this;
+            }
+
+            void copyFrom(const AudioBlock &source) {
+                for (size_t i = 0; i < numChannels; ++i)
+                    std::memcpy(static_cast<void *>(channels[i]), source.channels[i], numSamples * sizeof(Type));
+            }
+
+        private:
+            std::array<Type *, 16> channels{};
+            size_t numChannels = 0, numSamples = 0;
+        };
+
+        template<typename Type>
+        struct ProcessContextReplacing {
+            using SampleType = Type;
+            using AudioBlockType = AudioBlock<Type>;
+            using ConstAudioBlockType = AudioBlock<Type>;
+
+            ProcessContextReplacing(AudioBlock<Type> &block) : block(block) {}
+
+            const AudioBlock<Type> &getInputBlock() const { return block; }
+
+            AudioBlock<Type> &getOutputBlock() const { return block; }
+
+            constexpr bool usesSeparateInputAndOutputBlocks() const { return false; }
+
+            AudioBlock<Type> &block;
+            bool isBypassed = false;
+        };
+
+        template<typename... Processors>
+        class ProcessorChain {
+        public:
+            template<int Index>
+            auto &get() { return std::get<Index>(processors); }
+
+            template<int Index>
+            const auto &get() const { return std::get<Index>(processors); }
+
+            template<int Index>
+            void setBypassed(bool shouldBeBypassed) { bypassed[Index] = shouldBeBypassed; }
+
+            template<int Index>
+            bool isBypassed() const { return bypassed[Index]; }
+
+            void prepare(const ProcessSpec &spec) {
+                std::apply([&](auto &... processor) { (processor.prepare(spec), ...); }, processors);
+            }
+
+            void reset() {
+                std::apply([](auto &... processor) { (processor.reset(), ...); }, processors);
+            }
+
+            template<typename Context>
+            void process(const Context &context) {
+                size_t index = 0;
+
+                std::apply([&](auto &... processor) {
+                    (processOne(processor, context, bypassed[index++]), ...);
+                }, processors);
+            }
+
+        private:
+            template<typename Processor, typename Context>
+            static void processOne(Processor &processor, const Context &context, bool isBypassed) {
+                Context subContext(context.getOutputBlock());
+                subContext.isBypassed = isBypassed || context.isBypassed;
+                processor.process(subContext);
+            }
+
+            std::tuple<Processors...> processors;
+            std::array<bool, sizeof...(Processors)> bypassed{};
+        };
+
+        /** The Padé approximations from juce_FastMathApproximations.h. */
+        struct FastMathApproximations {
+            template<typename FloatType>
+            static FloatType tan(FloatType x) noexcept {
+                auto x2 = x * x;
+                auto numerator = x * (-135135 + x2 * (17325 + x2 * (-378 + x2)));
+                auto denominator = -135135 + x2 * (62370 + x2 * (-3150 + 28 * x2));
+                return numerator / denominator;
+            }
+
+            template<typename FloatType>
+            static FloatType sin(FloatType x) noexcept {
+                auto x2 = x * x;
+                auto numerator = -x * (-(FloatType) 11511339840 + x2 * ((FloatType) 1640635920
+                                       + x2 * (-(FloatType) 52785432 + x2 * (FloatType) 479249)));
+                auto denominator = (FloatType) 11511339840 + x2 * ((FloatType) 277920720
+                                   + x2 * ((FloatType) 3177720 + x2 * (FloatType) 18361));
+                return numerator / denominator;
+            }
+
+            template<typename FloatType>
+            static FloatType cos(FloatType x) noexcept {
+                auto x2 = x * x;
+                auto numerator = -(-(FloatType) 39251520 + x2 * ((FloatType) 18471600 + x2 * (-1075032 + 14615 * x2)));
+                auto denominator = (FloatType) 39251520 + x2 * ((FloatType) 1154160 + x2 * ((FloatType) 16632 + x2 * 127));
+                return numerator / denominator;
+            }
+        };
+    }
+}
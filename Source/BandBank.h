@@ -0,0 +1,152 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include "BiquadCascade.h"
+
+/**
+ Up to MaxBands independent biquad bands, stored as a structure of arrays:
+ each coefficient and each state variable has its own contiguous array,
+ indexed by slot.
+
+ Only active bands hold a slot, and the active slots are kept packed at the
+ front, so the bank runs numActive bands and never looks at the others; the
+ per-sample cost follows the number of bands in use, not MaxBands.
+ Switching a band off moves the last active band into its slot. The bands
+ are in series, so their order doesn't change the response.
+
+ Each active band runs over the whole block before the next one starts,
+ with its coefficients and state in registers. As in BiquadCascade, a
+ SIMDRegister SampleType processes one group of interleaved channels.
+ */
+template<typename SampleType, int MaxBands>
+class BandBank {
+public:
+    static constexpr int maxBands = MaxBands;
+
+    BandBank() {
+        slotOfBand.fill(-1);
+        reset();
+    }
+
+    void prepare(const juce::dsp::ProcessSpec &spec) {
+        jassert(spec.numChannels == 1);
+        juce::ignoreUnused(spec);
+        reset();
+    }
+
+    void reset() {
+        std::fill(s1.begin(), s1.end(), broadcast<SampleType>(0));
+        std::fill(s2.begin(), s2.end(), broadcast<SampleType>(0));
+    }
+
+    /** Sets the coefficients of a band. An inactive band gives up its slot and costs nothing. */
+    void setBand(int band, const BiquadCoefficients &coefficients, bool active) noexcept {
+        jassert(juce::isPositiveAndBelow(band, MaxBands));
+
+        auto slot = slotOfBand[(size_t) band];
+
+        if (!active) {
+            if (slot >= 0)
+                releaseSlot(slot);
+
+            return;
+        }
+
+        if (slot < 0) {
+            // newly active bands start from a cleared state
+            slot = numActive++;
+            slotOfBand[(size_t) band] = slot;
+            bandOfSlot[(size_t) slot] = band;
+            s1[(size_t) slot] = s2[(size_t) slot] = broadcast<SampleType>(0);
+        }
+
+        const auto index = (size_t) slot;
+        b0[index] = broadcast<SampleType>(coefficients.b0);
+        b1[index] = broadcast<SampleType>(coefficients.b1);
+        b2[index] = broadcast<SampleType>(coefficients.b2);
+        a1[index] = broadcast<SampleType>(coefficients.a1);
+        a2[index] = broadcast<SampleType>(coefficients.a2);
+    }
+
+    int getNumActiveBands() const { return numActive; }
+
+    /** Magnitude of the active bands at the given frequency. */
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const {
+        const auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto z1 = std::polar(1.0, -w);
+        const auto z2 = z1 * z1;
+
+        double magnitude = 1.0;
+
+        for (size_t i = 0; i < (size_t) numActive; ++i) {
+            const auto numerator = (double) b0[i] + (double) b1[i] * z1 + (double) b2[i] * z2;
+            const auto denominator = 1.0 + (double) a1[i] * z1 + (double) a2[i] * z2;
+            magnitude *= std::abs(numerator / denominator);
+        }
+
+        return magnitude;
+    }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext &context) noexcept {
+        const auto &inputBlock = context.getInputBlock();
+        auto &outputBlock = context.getOutputBlock();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert(inputBlock.getNumChannels() == 1);
+        jassert(outputBlock.getNumChannels() == 1);
+
+        if (context.usesSeparateInputAndOutputBlocks())
+            outputBlock.copyFrom(inputBlock);
+
+        if (context.isBypassed)
+            return;
+
+        auto *samples = outputBlock.getChannelPointer(0);
+
+        for (size_t slot = 0; slot < (size_t) numActive; ++slot) {
+            const auto cb0 = b0[slot], cb1 = b1[slot], cb2 = b2[slot], ca1 = a1[slot], ca2 = a2[slot];
+            auto z1 = s1[slot], z2 = s2[slot];
+
+            for (size_t i = 0; i < numSamples; ++i) {
+                const auto x = samples[i];
+                const auto y = cb0 * x + z1;
+                z1 = cb1 * x - ca1 * y + z2;
+                z2 = cb2 * x - ca2 * y;
+                samples[i] = y;
+            }
+
+            juce::dsp::util::snapToZero(z1);
+            juce::dsp::util::snapToZero(z2);
+            s1[slot] = z1;
+            s2[slot] = z2;
+        }
+    }
+
+private:
+    void releaseSlot(int slot) noexcept {
+        const auto last = --numActive;
+        slotOfBand[(size_t) bandOfSlot[(size_t) slot]] = -1;
+
+        if (slot != last) {
+            const auto from = (size_t) last, to = (size_t) slot;
+            b0[to] = b0[from];
+            b1[to] = b1[from];
+            b2[to] = b2[from];
+            a1[to] = a1[from];
+            a2[to] = a2[from];
+            s1[to] = s1[from];
+            s2[to] = s2[from];
+
+            bandOfSlot[to] = bandOfSlot[from];
+            slotOfBand[(size_t) bandOfSlot[to]] = slot;
+        }
+    }
+
+    std::array<SampleType, MaxBands> b0, b1, b2, a1, a2;
+    std::array<SampleType, MaxBands> s1, s2;
+
+    std::array<int, MaxBands> slotOfBand{}, bandOfSlot{};
+    int numActive = 0;
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include "FilterDesign.h"
+
+/**
+ Converts a scalar into the sample type of a filter. For SIMD registers the
+ value is copied into every lane.
+ */
+template<typename SampleType, typename NumericType>
+SampleType broadcast(NumericType value) noexcept {
+    if constexpr (std::is_floating_point_v<SampleType>)
+        return static_cast<SampleType>(value);
+    else
+        return SampleType::expand(static_cast<typename SampleType::ElementType>(value));
+}
+
+/**
+ Like broadcast, but with first in the even lanes and second in the odd ones,
+ so the two channels of each interleaved pair can get different values.
+ Scalars take first.
+ */
+template<typename SampleType, typename NumericType>
+SampleType broadcastPair(NumericType first, NumericType second) noexcept {
+    if constexpr (std::is_floating_point_v<SampleType>) {
+        juce::ignoreUnused(second);
+        return static_cast<SampleType>(first);
+    } else {
+        using Element = typename SampleType::ElementType;
+        SampleType result;
+
+        for (size_t lane = 0; lane < SampleType::size(); ++lane)
+            result.set(lane, static_cast<Element>(lane % 2 == 0 ? first : second));
+
+        return result;
+    }
+}
+
+/**
+ One second order section in transposed direct form II.
+ Coefficients are normalised so that a0 == 1 and are stored next to the
+ section state, so a whole cascade lives in one contiguous block. When
+ SampleType is a juce::dsp::SIMDRegister the coefficients are kept already
+ broadcast, so each lane (channel) is processed by the same instructions.
+ */
+template<typename SampleType>
+struct alignas(16) BiquadSection {
+    SampleType b0, b1, b2, a1, a2;
+    SampleType s1, s2;
+};
+
+/**
+ A cascade of up to MaxStages biquads that runs every active section in a
+ single pass per sample.
+
+ The number of active sections is chosen at runtime, but each stage count has
+ its own instantiation of the inner loop, so the sections can be unrolled and
+ kept in registers while the block is processed.
+ */
+template<typename SampleType, int MaxStages>
+class BiquadCascade {
+public:
+    static constexpr int maxStages = MaxStages;
+
+    BiquadCascade() {
+        for (auto &section: sections) {
+            section.b0 = broadcast<SampleType>(1);
+            section.b1 = section.b2 = section.a1 = section.a2 = broadcast<SampleType>(0);
+        }
+
+        reset();
+    }
+
+    void prepare(const juce::dsp::ProcessSpec &spec) {
+        // one channel per cascade, or one group of channels per SIMD register
+        jassert(spec.numChannels == 1);
+        juce::ignoreUnused(spec);
+        reset();
+    }
+
+    void reset() {
+        for (auto &section: sections)
+            section.s1 = section.s2 = broadcast<SampleType>(0);
+    }
+
+    void setSection(int index, const BiquadCoefficients &coefficients) noexcept {
+        jassert(juce::isPositiveAndBelow(index, MaxStages));
+
+        auto &section = sections[(size_t) index];
+
+        section.b0 = broadcast<SampleType>(coefficients.b0);
+        section.b1 = broadcast<SampleType>(coefficients.b1);
+        section.b2 = broadcast<SampleType>(coefficients.b2);
+        section.a1 = broadcast<SampleType>(coefficients.a1);
+        section.a2 = broadcast<SampleType>(coefficients.a2);
+    }
+
+    /** Sets a section to first in the even lanes and second in the odd ones. */
+    void setSection(int index, const BiquadCoefficients &first, const BiquadCoefficients &second) noexcept {
+        jassert(juce::isPositiveAndBelow(index, MaxStages));
+
+        auto &section = sections[(size_t) index];
+
+        section.b0 = broadcastPair<SampleType>(first.b0, second.b0);
+        section.b1 = broadcastPair<SampleType>(first.b1, second.b1);
+        section.b2 = broadcastPair<SampleType>(first.b2, second.b2);
+        section.a1 = broadcastPair<SampleType>(first.a1, second.a1);
+        section.a2 = broadcastPair<SampleType>(first.a2, second.a2);
+    }
+
+    /**
+     Changes how many sections are run. Sections that become active start from
+     a cleared state rather than whatever they held when they were switched off.
+     */
+    void setNumActiveStages(int newNumStages) noexcept {
+        jassert(newNumStages >= 0 && newNumStages <= MaxStages);
+
+        for (auto i = numActiveStages; i < newNumStages; ++i)
+            sections[(size_t) i].s1 = sections[(size_t) i].s2 = broadcast<SampleType>(0);
+
+        numActiveStages = newNumStages;
+    }
+
+    int getNumActiveStages() const { return numActiveStages; }
+
+    /** Magnitude of the active sections at the given frequency. */
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const {
+        const auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto z1 = std::polar(1.0, -w);
+        const auto z2 = z1 * z1;
+
+        double magnitude = 1.0;
+
+        for (int i = 0; i < numActiveStages; ++i) {
+            const auto &s = sections[(size_t) i];
+            const auto numerator = (double) s.b0 + (double) s.b1 * z1 + (double) s.b2 * z2;
+            const auto denominator = 1.0 + (double) s.a1 * z1 + (double) s.a2 * z2;
+            magnitude *= std::abs(numerator / denominator);
+        }
+
+        return magnitude;
+    }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext &context) noexcept {
+        const auto &inputBlock = context.getInputBlock();
+        auto &outputBlock = context.getOutputBlock();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert(inputBlock.getNumChannels() == 1);
+        jassert(outputBlock.getNumChannels() == 1);
+        jassert(inputBlock.getNumSamples() == numSamples);
+
+        if (context.isBypassed || numActiveStages == 0) {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom(inputBlock);
+
+            return;
+        }
+
+        auto *input = inputBlock.getChannelPointer(0);
+        auto *output = outputBlock.getChannelPointer(0);
+
+        // only the stage counts the cascade has are instantiated
+        switch (numActiveStages) {
+            case 1: processStages<1>(input, output, numSamples);
+                break;
+            case 2: if constexpr (MaxStages >= 2) processStages<2>(input, output, numSamples);
+                break;
+            case 3: if constexpr (MaxStages >= 3) processStages<3>(input, output, numSamples);
+                break;
+            case 4: if constexpr (MaxStages >= 4) processStages<4>(input, output, numSamples);
+                break;
+            default: jassertfalse;
+                break;
+        }
+    }
+
+private:
+    template<int NumStages>
+    void processStages(const SampleType *input, SampleType *output, size_t numSamples) noexcept {
+        static_assert(NumStages <= MaxStages, "cascade does not have that many sections");
+
+        // Work on a local copy so the sections can stay in registers; the
+        // output pointer could otherwise alias the state as far as the
+        // compiler knows.
+        alignas(16) BiquadSection<SampleType> local[NumStages];
+        for (int s = 0; s < NumStages; ++s)
+            local[s] = sections[(size_t) s];
+
+        for (size_t i = 0; i < numSamples; ++i) {
+            auto x = input[i];
+
+            for (int s = 0; s < NumStages; ++s) {
+                auto &section = local[s];
+                const auto y = section.b0 * x + section.s1;
+                section.s1 = section.b1 * x - section.a1 * y + section.s2;
+                section.s2 = section.b2 * x - section.a2 * y;
+                x = y;
+            }
+
+            output[i] = x;
+        }
+
+        for (int s = 0; s < NumStages; ++s) {
+            juce::dsp::util::snapToZero(local[s].s1);
+            juce::dsp::util::snapToZero(local[s].s2);
+            sections[(size_t) s].s1 = local[s].s1;
+            sections[(size_t) s].s2 = local[s].s2;
+        }
+    }
+
+    std::array<BiquadSection<SampleType>, MaxStages> sections;
+    int numActiveStages = 0;
+};
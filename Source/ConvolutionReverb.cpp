@@ -0,0 +1,143 @@
+#include "ConvolutionReverb.h"
+
+ConvolutionReverb::ConvolutionReverb() : juce::Thread("Convolution IR loader") {
+    for (auto &engine: engines)
+        engine = std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::NonUniform{headSizeInSamples},
+                                                          *messageQueue);
+
+    startThread();
+}
+
+ConvolutionReverb::~ConvolutionReverb() {
+    stopThread(2000);
+}
+
+void ConvolutionReverb::prepare(const juce::dsp::ProcessSpec &spec) {
+    bool hasImpulseResponse;
+    {
+        const juce::ScopedLock lock(loadLock);
+
+        numEngines = juce::jmin(maxNumEngines, ((int) spec.numChannels + 1) / 2);
+        sampleRate = spec.sampleRate;
+
+        // the engines past numEngines stay unprepared until a wider bus needs them
+        const juce::dsp::ProcessSpec pairSpec{spec.sampleRate, spec.maximumBlockSize, 2};
+        for (int engine = 0; engine < numEngines; ++engine)
+            engines[(size_t) engine]->prepare(pairSpec);
+
+        dryBuffer.setSize((int) spec.numChannels, (int) spec.maximumBlockSize);
+
+        wetGain.reset(sampleRate, 0.01);
+        dryGain.reset(sampleRate, 0.01);
+
+        hasImpulseResponse = impulseResponse.getNumSamples() > 0;
+    }
+
+    // a loaded IR goes to the engines again, resampled to the new rate
+    if (hasImpulseResponse) {
+        loadPending = true;
+        notify();
+    }
+}
+
+void ConvolutionReverb::reset() {
+    for (int engine = 0; engine < numEngines; ++engine)
+        engines[(size_t) engine]->reset();
+
+    wetGain.setCurrentAndTargetValue(wetGain.getTargetValue());
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+}
+
+void ConvolutionReverb::loadImpulseResponse(const juce::File &file) {
+    {
+        const juce::SpinLock::ScopedLockType lock(fileLock);
+        pendingFile = file;
+    }
+
+    loadPending = true;
+    notify();
+}
+
+void ConvolutionReverb::run() {
+    while (!threadShouldExit()) {
+        if (loadPending.exchange(false))
+            loadEngines();
+
+        wait(-1);
+    }
+}
+
+void ConvolutionReverb::loadEngines() {
+    const juce::ScopedLock lock(loadLock);
+
+    juce::File file;
+    {
+        const juce::SpinLock::ScopedLockType fileScope(fileLock);
+        std::swap(file, pendingFile);
+    }
+
+    if (file != juce::File()) {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        const std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr)
+            return;
+
+        impulseResponse.setSize(juce::jmin(2, (int) reader->numChannels), (int) reader->lengthInSamples);
+        reader->read(&impulseResponse, 0, impulseResponse.getNumSamples(), 0, true, true);
+        impulseResponseRate = reader->sampleRate;
+    }
+
+    if (impulseResponse.getNumSamples() == 0 || numEngines == 0)
+        return;
+
+    // the same resampling juce::dsp::Convolution does, once for all engines
+    auto resampled = impulseResponse;
+
+    if (impulseResponseRate != sampleRate) {
+        const auto ratio = impulseResponseRate / sampleRate;
+        const auto numSamples = juce::roundToInt(juce::jmax(1.0, impulseResponse.getNumSamples() / ratio));
+
+        juce::MemoryAudioSource source(impulseResponse, false);
+        juce::ResamplingAudioSource resampler(&source, false, impulseResponse.getNumChannels());
+        resampler.setResamplingRatio(ratio);
+        resampler.prepareToPlay(numSamples, impulseResponseRate);
+
+        resampled.setSize(impulseResponse.getNumChannels(), numSamples);
+        resampler.getNextAudioBlock(juce::AudioSourceChannelInfo(resampled));
+    }
+
+    for (int engine = 0; engine < numEngines; ++engine)
+        engines[(size_t) engine]->loadImpulseResponse(juce::AudioBuffer<float>(resampled), sampleRate,
+                                                      juce::dsp::Convolution::Stereo::yes,
+                                                      juce::dsp::Convolution::Trim::yes,
+                                                      juce::dsp::Convolution::Normalise::yes);
+}
+
+void ConvolutionReverb::setLevels(float newWetGain, float newDryGain) {
+    wetGain.setTargetValue(newWetGain);
+    dryGain.setTargetValue(newDryGain);
+}
+
+void ConvolutionReverb::process(const juce::dsp::ProcessContextReplacing<float> &context) {
+    auto &block = context.getOutputBlock();
+    const auto numChannels = block.getNumChannels();
+
+    auto dryBlock = juce::dsp::AudioBlock<float>(dryBuffer).getSubBlock(0, block.getNumSamples())
+            .getSubsetChannelBlock(0, numChannels);
+    dryBlock.copyFrom(block);
+
+    for (size_t engine = 0; engine < (size_t) numEngines && engine * 2 < numChannels; ++engine) {
+        auto pairBlock = block.getSubsetChannelBlock(engine * 2, juce::jmin((size_t) 2, numChannels - engine * 2));
+        engines[engine]->process(juce::dsp::ProcessContextReplacing<float>(pairBlock));
+    }
+
+    block.multiplyBy(wetGain);
+    dryBlock.multiplyBy(dryGain);
+    block.add(dryBlock);
+}
+
+double ConvolutionReverb::getTailLengthSeconds() const {
+    return (double) engines[0]->getCurrentIRSize() / sampleRate;
+}
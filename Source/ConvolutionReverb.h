@@ -0,0 +1,72 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+/**
+ Reverb from a recorded impulse response, the alternative to the algorithmic
+ juce::dsp::Reverb.
+
+ The convolution is non-uniformly partitioned: a short head runs with
+ small partitions, so there is no added latency, and the rest of the
+ response runs with long partitions, so even IRs of several seconds cost
+ little per block. A new IR is read once and resampled once per sample rate
+ on a loader thread, and every engine gets a copy of the result; partitioning
+ happens on a background thread shared by every instance of the plugin. The
+ audio thread picks the result up without blocking and crossfades to it.
+ */
+class ConvolutionReverb : private juce::Thread {
+public:
+    ConvolutionReverb();
+
+    ~ConvolutionReverb() override;
+
+    /** Prepares only the engines the bus needs; a loaded IR is resampled and loaded into them again. */
+    void prepare(const juce::dsp::ProcessSpec &spec);
+
+    void reset();
+
+    /** Starts loading an IR from disk; may be called while audio is running. */
+    void loadImpulseResponse(const juce::File &file);
+
+    /** Target gains for the convolved and the untouched signal, reached over a few ms. */
+    void setLevels(float wetGain, float dryGain);
+
+    void process(const juce::dsp::ProcessContextReplacing<float> &context);
+
+    /** The length of the IR currently in use (zero until one has loaded). */
+    double getTailLengthSeconds() const;
+
+private:
+    void run() override;
+
+    /** Reads a pending file, then loads the IR, at the prepared rate, into every engine in use. */
+    void loadEngines();
+
+    static constexpr int headSizeInSamples = 256;
+
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> messageQueue;
+
+    // juce::dsp::Convolution handles at most two channels, so wider buses run
+    // one engine per pair of channels.
+    static constexpr int maxNumEngines = (BassQualizerAudioProcessor::maxNumChannels + 1) / 2;
+    std::array<std::unique_ptr<juce::dsp::Convolution>, maxNumEngines> engines;
+    int numEngines = 0;
+
+    juce::SpinLock fileLock;
+    juce::File pendingFile;
+    std::atomic<bool> loadPending{false};
+
+    // Everything below belongs to the loader thread; prepare() takes the lock
+    // to change it. The IR is kept as read, at its own rate, so every new
+    // sample rate resamples it from the original.
+    juce::CriticalSection loadLock;
+    juce::AudioBuffer<float> impulseResponse;
+    double impulseResponseRate = 0.0;
+
+    double sampleRate = 44100.0;
+    juce::AudioBuffer<float> dryBuffer;
+    juce::SmoothedValue<float> wetGain, dryGain;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionReverb)
+};
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ Stereo feedback delay network reverb, the dense alternative to the comb and
+ allpass network of juce::dsp::Reverb.
+
+ Sixteen delay lines of mutually unrelated lengths feed back through a
+ Householder matrix (every line gets itself minus 2/N of the sum of all
+ lines), which is lossless and mixes every line into every other on each
+ pass. Apart from reading and writing the lines, the per-sample work (the
+ damping low pass, the mixing, the decay gains and the output taps) runs on
+ whole SIMD registers of lines at a time.
+
+ Takes the same parameters as juce::dsp::Reverb, and room size gives the
+ same decay time. The network can run at half the sample rate, which halves
+ its cost and the memory it touches; a bass bus rarely has much to reverberate
+ above a quarter of the sample rate.
+
+ Runs in either precision, so the double path doesn't convert around it.
+ */
+template<typename SampleType>
+class FdnReverb {
+public:
+    static constexpr int numLines = 16;
+
+    void prepare(const juce::dsp::ProcessSpec &spec) {
+        sampleRate = spec.sampleRate;
+
+        for (size_t i = 0; i < (size_t) numLines; ++i)
+            delayLines[i].assign((size_t) std::ceil(lineLengthsAt44k[i] * sampleRate / 44100.0) + 1, SampleType(0));
+
+        // Left feeds and is read from the even lines, right from the odd ones,
+        // with alternating signs so the two sides stay uncorrelated.
+        const auto outputGain = SampleType(1) / std::sqrt(SampleType(numLines) * SampleType(0.5));
+
+        for (int i = 0; i < numLines; ++i) {
+            const auto vector = (size_t) (i / (int) Vector::SIMDNumElements);
+            const auto lane = (size_t) (i % (int) Vector::SIMDNumElements);
+            const auto sign = (i / 2) % 2 == 0 ? SampleType(1) : SampleType(-1);
+            const auto isLeft = i % 2 == 0;
+
+            leftInputGains[vector].set(lane, isLeft ? sign * inputGain : SampleType(0));
+            rightInputGains[vector].set(lane, isLeft ? SampleType(0) : sign * inputGain);
+            leftOutputTaps[vector].set(lane, isLeft ? sign * outputGain : SampleType(0));
+            rightOutputTaps[vector].set(lane, isLeft ? SampleType(0) : sign * outputGain);
+        }
+
+        for (auto *gain: {&dryGain, &wetGain1, &wetGain2})
+            gain->reset(sampleRate, 0.01);
+
+        updateLineLengths();
+        updateGains();
+        reset();
+    }
+
+    void reset() {
+        for (auto &line: delayLines)
+            std::fill(line.begin(), line.end(), SampleType(0));
+
+        positions.fill(0);
+
+        for (auto &state: dampingStates)
+            state = Vector::expand(SampleType(0));
+
+        for (auto *halfBand: {&leftDecimator, &rightDecimator, &leftInterpolator, &rightInterpolator})
+            halfBand->reset();
+
+        halfRatePhase = 0;
+        lowRateLeft = lowRateRight = SampleType(0);
+
+        for (auto *gain: {&dryGain, &wetGain1, &wetGain2})
+            gain->setCurrentAndTargetValue(gain->getTargetValue());
+    }
+
+    void setParameters(const juce::dsp::Reverb::Parameters &newParameters) {
+        parameters = newParameters;
+        updateGains();
+    }
+
+    /** Switching the rate restarts the network from silence. */
+    void setHalfRate(bool shouldRunAtHalfRate) {
+        if (halfRate == shouldRunAtHalfRate)
+            return;
+
+        halfRate = shouldRunAtHalfRate;
+        updateLineLengths();
+        updateGains();
+        reset();
+    }
+
+    /** Processes one or two channels; a mono block feeds and reads both sides. */
+    void process(const juce::dsp::ProcessContextReplacing<SampleType> &context) noexcept {
+        auto &block = context.getOutputBlock();
+        const auto numChannels = block.getNumChannels();
+        const auto numSamples = block.getNumSamples();
+        jassert(numChannels == 1 || numChannels == 2);
+
+        auto *left = block.getChannelPointer(0);
+        auto *right = numChannels > 1 ? block.getChannelPointer(1) : left;
+
+        for (size_t i = 0; i < numSamples; ++i) {
+            const auto inputLeft = left[i], inputRight = right[i];
+            SampleType wetLeft, wetRight;
+
+            if (halfRate) {
+                const auto decimatedLeft = leftDecimator.process(inputLeft);
+                const auto decimatedRight = rightDecimator.process(inputRight);
+
+                if (halfRatePhase == 0)
+                    tick(decimatedLeft, decimatedRight, lowRateLeft, lowRateRight);
+
+                // zero stuffed, so the interpolator needs twice the gain
+                wetLeft = leftInterpolator.process(halfRatePhase == 0 ? SampleType(2) * lowRateLeft : SampleType(0));
+                wetRight = rightInterpolator.process(halfRatePhase == 0 ? SampleType(2) * lowRateRight : SampleType(0));
+                halfRatePhase ^= 1;
+            } else {
+                tick(inputLeft, inputRight, wetLeft, wetRight);
+            }
+
+            const auto dry = dryGain.getNextValue();
+            const auto wet1 = wetGain1.getNextValue();
+            const auto wet2 = wetGain2.getNextValue();
+
+            left[i] = inputLeft * dry + wetLeft * wet1 + wetRight * wet2;
+
+            if (numChannels > 1)
+                right[i] = inputRight * dry + wetRight * wet1 + wetLeft * wet2;
+        }
+    }
+
+private:
+    using Vector = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr int numVectors = numLines / (int) Vector::SIMDNumElements;
+    static_assert(numLines % Vector::SIMDNumElements == 0, "the lines have to fill whole registers");
+
+    // prime lengths at 44.1 kHz, 23 to 67 ms
+    static constexpr std::array<int, numLines> lineLengthsAt44k{
+        1031, 1151, 1277, 1399, 1523, 1657, 1789, 1907, 2039, 2161, 2297, 2423, 2551, 2683, 2803, 2939
+    };
+
+    // juce::Reverb's output scaling, and its longest comb: room size gives
+    // the same decay per second here as it gives that comb
+    static constexpr SampleType dryScaleFactor = 2, wetScaleFactor = 3;
+    static constexpr double referenceCombSeconds = 1640.0 / 44100.0;
+
+    // puts the wet level at about that of juce::Reverb
+    static constexpr SampleType inputGain = SampleType(0.025);
+
+    /** 7 tap half band low pass, shared by the decimation and the interpolation. */
+    struct HalfBand {
+        static constexpr std::array<SampleType, 7> coefficients{
+            SampleType(-0.0322), 0, SampleType(0.2822), SampleType(0.5), SampleType(0.2822), 0, SampleType(-0.0322)
+        };
+
+        SampleType process(SampleType input) noexcept {
+            std::copy_backward(history.begin(), history.end() - 1, history.end());
+            history[0] = input;
+
+            auto output = SampleType(0);
+            for (size_t j = 0; j < history.size(); ++j)
+                output += history[j] * coefficients[j];
+
+            return output;
+        }
+
+        void reset() { history.fill(SampleType(0)); }
+
+        std::array<SampleType, 7> history{};
+    };
+
+    void updateLineLengths() {
+        const auto rate = halfRate ? sampleRate * 0.5 : sampleRate;
+
+        for (size_t i = 0; i < (size_t) numLines; ++i) {
+            lengths[i] = juce::jlimit(1, (int) delayLines[i].size(),
+                                      juce::roundToInt(lineLengthsAt44k[i] * rate / 44100.0));
+            positions[i] = 0;
+        }
+    }
+
+    void updateGains() {
+        const auto rate = halfRate ? sampleRate * 0.5 : sampleRate;
+        const auto frozen = parameters.freezeMode;
+
+        // decay in nepers per sample at the internal rate
+        const auto feedback = parameters.roomSize * 0.28 + 0.7;
+        const auto decayPerSample = std::log(feedback) / (referenceCombSeconds * rate);
+
+        for (int i = 0; i < numLines; ++i)
+            feedbackGains[(size_t) (i / (int) Vector::SIMDNumElements)].set(
+                (size_t) (i % (int) Vector::SIMDNumElements),
+                frozen ? SampleType(1) : (SampleType) std::exp(decayPerSample * lengths[(size_t) i]));
+
+        // the pole juce::Reverb uses; two steps of it per step at half rate
+        damping = frozen ? SampleType(0) : (SampleType) parameters.damping * SampleType(0.4);
+        if (halfRate)
+            damping *= damping;
+
+        const auto wet = (SampleType) parameters.wetLevel * wetScaleFactor;
+        const auto width = (SampleType) parameters.width;
+        dryGain.setTargetValue((SampleType) parameters.dryLevel * dryScaleFactor);
+        wetGain1.setTargetValue(SampleType(0.5) * wet * (SampleType(1) + width));
+        wetGain2.setTargetValue(SampleType(0.5) * wet * (SampleType(1) - width));
+    }
+
+    /** One step of the network at its internal rate. */
+    void tick(SampleType left, SampleType right, SampleType &wetLeft, SampleType &wetRight) noexcept {
+        alignas(Vector::SIMDRegisterSize) std::array<SampleType, numLines> taps;
+
+        for (size_t i = 0; i < (size_t) numLines; ++i)
+            taps[i] = delayLines[i][(size_t) positions[i]];
+
+        auto sum = Vector::expand(SampleType(0)), leftSum = sum, rightSum = sum;
+
+        for (size_t v = 0; v < (size_t) numVectors; ++v) {
+            const auto delayed = Vector::fromRawArray(taps.data() + v * Vector::SIMDNumElements);
+            dampingStates[v] = delayed + (dampingStates[v] - delayed) * damping;
+
+            sum += dampingStates[v];
+            leftSum += dampingStates[v] * leftOutputTaps[v];
+            rightSum += dampingStates[v] * rightOutputTaps[v];
+        }
+
+        // Householder reflection: each line minus 2/N of the sum of all lines
+        const auto reflection = Vector::expand(sum.sum() * (SampleType(2) / numLines));
+
+        if (parameters.freezeMode)
+            left = right = SampleType(0);
+
+        for (size_t v = 0; v < (size_t) numVectors; ++v) {
+            const auto fed = (dampingStates[v] - reflection) * feedbackGains[v]
+                             + leftInputGains[v] * left + rightInputGains[v] * right;
+            fed.copyToRawArray(taps.data() + v * Vector::SIMDNumElements);
+        }
+
+        for (size_t i = 0; i < (size_t) numLines; ++i) {
+            delayLines[i][(size_t) positions[i]] = taps[i];
+
+            if (++positions[i] == lengths[i])
+                positions[i] = 0;
+        }
+
+        wetLeft = leftSum.sum();
+        wetRight = rightSum.sum();
+    }
+
+    juce::dsp::Reverb::Parameters parameters;
+    double sampleRate = 44100.0;
+    bool halfRate = false;
+    int halfRatePhase = 0;
+
+    std::array<std::vector<SampleType>, numLines> delayLines;
+    std::array<int, numLines> lengths{}, positions{};
+
+    std::array<Vector, numVectors> dampingStates, feedbackGains,
+            leftInputGains, rightInputGains, leftOutputTaps, rightOutputTaps;
+    SampleType damping = 0;
+
+    HalfBand leftDecimator, rightDecimator, leftInterpolator, rightInterpolator;
+    SampleType lowRateLeft = 0, lowRateRight = 0;
+
+    juce::SmoothedValue<SampleType> dryGain, wetGain1, wetGain2;
+};
@@ -0,0 +1,498 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ Plain biquad coefficients, normalised so that a0 == 1.
+ Unlike juce::dsp::IIR::Coefficients these are a value type, so designing a
+ filter never touches the heap and is safe to do on the audio thread.
+ */
+struct BiquadCoefficients {
+    double b0{1.0}, b1{0.0}, b2{0.0}, a1{0.0}, a2{0.0};
+
+    bool operator==(const BiquadCoefficients &other) const {
+        return b0 == other.b0 && b1 == other.b1 && b2 == other.b2 && a1 == other.a1 && a2 == other.a2;
+    }
+
+    bool operator!=(const BiquadCoefficients &other) const { return !(*this == other); }
+};
+
+/** The sections of a higher order filter, first section first. */
+template<int MaxSections, typename SectionCoefficients = BiquadCoefficients>
+struct CascadeCoefficients {
+    std::array<SectionCoefficients, MaxSections> sections;
+    int numSections{0};
+
+    const SectionCoefficients &operator[](int index) const { return sections[(size_t) index]; }
+};
+
+/** Trigonometry used by the designers below: the standard library... */
+struct PreciseMath {
+    static double sin(double x) { return std::sin(x); }
+    static double cos(double x) { return std::cos(x); }
+    static double tan(double x) { return std::tan(x); }
+};
+
+/**
+ ...or rational approximations, for redesigns that happen every few samples
+ (modulation). Valid for the 0..pi range the designers use.
+ */
+struct FastMath {
+    static double sin(double x) { return juce::dsp::FastMathApproximations::sin(x); }
+    static double cos(double x) { return juce::dsp::FastMathApproximations::cos(x); }
+    static double tan(double x) { return juce::dsp::FastMathApproximations::tan(x); }
+};
+
+/**
+ The parts of a bilinear peak design that depend on frequency and Q only.
+ A peak whose gain moves on its own (the dynamic mode) is redesigned from
+ these with a square root and a division, no trigonometry.
+ */
+struct PeakPrototype {
+    double alpha{0.0}, c2{-2.0};
+
+    template<typename Math = PreciseMath>
+    static PeakPrototype at(double sampleRate, double frequency, double Q) {
+        jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0);
+
+        const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        return {Math::sin(omega) / (Q * 2.0), -2.0 * Math::cos(omega)};
+    }
+
+    /** Same formula as juce::dsp::IIR::Coefficients::makePeakFilter. */
+    BiquadCoefficients getCoefficients(double gainFactor) const {
+        jassert(gainFactor > 0.0);
+
+        const auto A = std::sqrt(gainFactor);
+        const auto alphaTimesA = alpha * A;
+        const auto alphaOverA = alpha / A;
+        const auto a0 = 1.0 / (1.0 + alphaOverA);
+
+        return {
+            (1.0 + alphaTimesA) * a0,
+            c2 * a0,
+            (1.0 - alphaTimesA) * a0,
+            c2 * a0,
+            (1.0 - alphaOverA) * a0
+        };
+    }
+};
+
+template<typename Math = PreciseMath>
+BiquadCoefficients makePeakCoefficients(double sampleRate, double frequency, double Q, double gainFactor) {
+    return PeakPrototype::at<Math>(sampleRate, frequency, Q).getCoefficients(gainFactor);
+}
+
+/** Same formula as juce::dsp::IIR::Coefficients::makeHighPass. */
+template<typename Math = PreciseMath>
+BiquadCoefficients makeHighPassCoefficients(double sampleRate, double frequency, double Q) {
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0);
+
+    const auto n = Math::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    const auto nSquared = n * n;
+    const auto invQ = 1.0 / Q;
+    const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    return {
+        c1,
+        c1 * -2.0,
+        c1,
+        c1 * 2.0 * (nSquared - 1.0),
+        c1 * (1.0 - invQ * n + nSquared)
+    };
+}
+
+/** Same formula as juce::dsp::IIR::Coefficients::makeLowPass. */
+template<typename Math = PreciseMath>
+BiquadCoefficients makeLowPassCoefficients(double sampleRate, double frequency, double Q) {
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0);
+
+    const auto n = 1.0 / Math::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    const auto nSquared = n * n;
+    const auto invQ = 1.0 / Q;
+    const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    return {
+        c1,
+        c1 * 2.0,
+        c1,
+        c1 * 2.0 * (1.0 - nSquared),
+        c1 * (1.0 - invQ * n + nSquared)
+    };
+}
+
+/**
+ Second order allpass with the poles of makeLowPassCoefficients at the same
+ frequency and Q. A Linkwitz-Riley pair built from that low pass sums to it.
+ */
+template<typename Math = PreciseMath>
+BiquadCoefficients makeAllPassCoefficients(double sampleRate, double frequency, double Q) {
+    const auto lowPass = makeLowPassCoefficients<Math>(sampleRate, frequency, Q);
+    return {lowPass.a2, lowPass.a1, 1.0, lowPass.a1, lowPass.a2};
+}
+
+/** Same formula as juce::dsp::IIR::Coefficients::makeLowShelf. */
+template<typename Math = PreciseMath>
+BiquadCoefficients makeLowShelfCoefficients(double sampleRate, double frequency, double Q, double gainFactor) {
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0 && gainFactor > 0.0);
+
+    const auto A = std::sqrt(gainFactor);
+    const auto aMinus1 = A - 1.0;
+    const auto aPlus1 = A + 1.0;
+    const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const auto coso = Math::cos(omega);
+    const auto beta = Math::sin(omega) * std::sqrt(A) / Q;
+    const auto aMinus1TimesCoso = aMinus1 * coso;
+    const auto a0 = 1.0 / (aPlus1 + aMinus1TimesCoso + beta);
+
+    return {
+        A * (aPlus1 - aMinus1TimesCoso + beta) * a0,
+        A * 2.0 * (aMinus1 - aPlus1 * coso) * a0,
+        A * (aPlus1 - aMinus1TimesCoso - beta) * a0,
+        -2.0 * (aMinus1 + aPlus1 * coso) * a0,
+        (aPlus1 + aMinus1TimesCoso - beta) * a0
+    };
+}
+
+/** Same formula as juce::dsp::IIR::Coefficients::makeHighShelf. */
+template<typename Math = PreciseMath>
+BiquadCoefficients makeHighShelfCoefficients(double sampleRate, double frequency, double Q, double gainFactor) {
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0 && gainFactor > 0.0);
+
+    const auto A = std::sqrt(gainFactor);
+    const auto aMinus1 = A - 1.0;
+    const auto aPlus1 = A + 1.0;
+    const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const auto coso = Math::cos(omega);
+    const auto beta = Math::sin(omega) * std::sqrt(A) / Q;
+    const auto aMinus1TimesCoso = aMinus1 * coso;
+    const auto a0 = 1.0 / (aPlus1 - aMinus1TimesCoso + beta);
+
+    return {
+        A * (aPlus1 + aMinus1TimesCoso + beta) * a0,
+        A * -2.0 * (aMinus1 + aPlus1 * coso) * a0,
+        A * (aPlus1 + aMinus1TimesCoso - beta) * a0,
+        2.0 * (aMinus1 - aPlus1 * coso) * a0,
+        (aPlus1 - aMinus1TimesCoso - beta) * a0
+    };
+}
+
+/** Same formula as juce::dsp::IIR::Coefficients::makeNotch. */
+template<typename Math = PreciseMath>
+BiquadCoefficients makeNotchCoefficients(double sampleRate, double frequency, double Q) {
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0);
+
+    const auto n = 1.0 / Math::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    const auto nSquared = n * n;
+    const auto invQ = 1.0 / Q;
+    const auto c1 = 1.0 / (1.0 + n * invQ + nSquared);
+    const auto b0 = c1 * (1.0 + nSquared);
+    const auto b1 = 2.0 * c1 * (1.0 - nSquared);
+
+    return {b0, b1, b0, b1, c1 * (1.0 - n * invQ + nSquared)};
+}
+
+/**
+ The two stages of the ITU-R BS.1770 K-weighting filter, a +4 dB high shelf
+ and a high pass at 38 Hz, designed for any sample rate.
+ */
+inline BiquadCoefficients makeKWeightingShelfCoefficients(double sampleRate) {
+    const auto K = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+    const auto Q = 0.7071752369554196;
+    const auto Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    const auto Vb = std::pow(Vh, 0.4996667741545416);
+    const auto a0 = 1.0 + K / Q + K * K;
+
+    return {
+        (Vh + Vb * K / Q + K * K) / a0,
+        2.0 * (K * K - Vh) / a0,
+        (Vh - Vb * K / Q + K * K) / a0,
+        2.0 * (K * K - 1.0) / a0,
+        (1.0 - K / Q + K * K) / a0
+    };
+}
+
+inline BiquadCoefficients makeKWeightingHighPassCoefficients(double sampleRate) {
+    const auto K = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+    const auto Q = 0.5003270373238773;
+    const auto a0 = 1.0 + K / Q + K * K;
+
+    return {1.0, -2.0, 1.0, 2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0};
+}
+
+/** Q of section i of an even order Butterworth filter. */
+template<typename Math = PreciseMath>
+double getButterworthQ(int order, int section) {
+    return 1.0 / (2.0 * Math::cos((2.0 * section + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+}
+
+/**
+ Even order Butterworth high pass, split into second order sections the same
+ way as juce::dsp::FilterDesign::designIIRHighpassHighOrderButterworthMethod.
+ */
+template<int MaxSections, typename Math = PreciseMath>
+CascadeCoefficients<MaxSections> designButterworthHighPass(double frequency, double sampleRate, int order) {
+    jassert(order > 0 && order % 2 == 0 && order / 2 <= MaxSections);
+
+    CascadeCoefficients<MaxSections> result;
+    result.numSections = order / 2;
+
+    for (int i = 0; i < result.numSections; ++i)
+        result.sections[(size_t) i] = makeHighPassCoefficients<Math>(sampleRate, frequency, getButterworthQ<Math>(order, i));
+
+    return result;
+}
+
+/** Even order Butterworth low pass, see designButterworthHighPass. */
+template<int MaxSections, typename Math = PreciseMath>
+CascadeCoefficients<MaxSections> designButterworthLowPass(double frequency, double sampleRate, int order) {
+    jassert(order > 0 && order % 2 == 0 && order / 2 <= MaxSections);
+
+    CascadeCoefficients<MaxSections> result;
+    result.numSections = order / 2;
+
+    for (int i = 0; i < result.numSections; ++i)
+        result.sections[(size_t) i] = makeLowPassCoefficients<Math>(sampleRate, frequency, getButterworthQ<Math>(order, i));
+
+    return result;
+}
+
+/**
+ Coefficients of a topology-preserving-transform state variable filter
+ (trapezoidal integration, see Zavalishin / Simper). The response of one
+ section is
+
+     H(s) = m0 + (m1 * s + m2) / (s^2 + k * s + 1),   s = s_analog / wc
+
+ with the cutoff prewarped into g = tan(pi * fc / fs), so the magnitude matches
+ the bilinear biquad designs above while the structure stays well behaved when
+ the coefficients change every few samples.
+ */
+struct SvfCoefficients {
+    double g{0.0}, k{2.0}, m0{1.0}, m1{0.0}, m2{0.0};
+};
+
+template<typename Math = PreciseMath>
+double prewarpSvfCutoff(double sampleRate, double frequency) {
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency < sampleRate * 0.5);
+    return Math::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+}
+
+/** A peak at an already prewarped cutoff g; the gain-only redesign of the state variable peak. */
+inline SvfCoefficients makeSvfPeakAtCutoff(double g, double Q, double gainFactor) {
+    const auto A = std::sqrt(gainFactor);
+    const auto k = 1.0 / (Q * A);
+    return {g, k, 1.0, k * (A * A - 1.0), 0.0};
+}
+
+template<typename Math = PreciseMath>
+SvfCoefficients makeSvfPeak(double sampleRate, double frequency, double Q, double gainFactor) {
+    return makeSvfPeakAtCutoff(prewarpSvfCutoff<Math>(sampleRate, frequency), Q, gainFactor);
+}
+
+/** Band pass with unity gain at the centre frequency. */
+template<typename Math = PreciseMath>
+SvfCoefficients makeSvfBandPass(double sampleRate, double frequency, double Q) {
+    const auto k = 1.0 / Q;
+    return {prewarpSvfCutoff<Math>(sampleRate, frequency), k, 0.0, k, 0.0};
+}
+
+template<typename Math = PreciseMath>
+SvfCoefficients makeSvfHighPass(double sampleRate, double frequency, double Q) {
+    const auto k = 1.0 / Q;
+    return {prewarpSvfCutoff<Math>(sampleRate, frequency), k, 1.0, -k, -1.0};
+}
+
+template<typename Math = PreciseMath>
+SvfCoefficients makeSvfLowPass(double sampleRate, double frequency, double Q) {
+    return {prewarpSvfCutoff<Math>(sampleRate, frequency), 1.0 / Q, 0.0, 0.0, 1.0};
+}
+
+/** Butterworth high pass as state variable sections, see designButterworthHighPass. */
+template<int MaxSections, typename Math = PreciseMath>
+CascadeCoefficients<MaxSections, SvfCoefficients> designButterworthHighPassSvf(double frequency, double sampleRate,
+                                                                               int order) {
+    jassert(order > 0 && order % 2 == 0 && order / 2 <= MaxSections);
+
+    CascadeCoefficients<MaxSections, SvfCoefficients> result;
+    result.numSections = order / 2;
+
+    for (int i = 0; i < result.numSections; ++i)
+        result.sections[(size_t) i] = makeSvfHighPass<Math>(sampleRate, frequency, getButterworthQ<Math>(order, i));
+
+    return result;
+}
+
+/** Butterworth low pass as state variable sections, see designButterworthLowPass. */
+template<int MaxSections, typename Math = PreciseMath>
+CascadeCoefficients<MaxSections, SvfCoefficients> designButterworthLowPassSvf(double frequency, double sampleRate,
+                                                                              int order) {
+    jassert(order > 0 && order % 2 == 0 && order / 2 <= MaxSections);
+
+    CascadeCoefficients<MaxSections, SvfCoefficients> result;
+    result.numSections = order / 2;
+
+    for (int i = 0; i < result.numSections; ++i)
+        result.sections[(size_t) i] = makeSvfLowPass<Math>(sampleRate, frequency, getButterworthQ<Math>(order, i));
+
+    return result;
+}
+
+/**
+ Magnitude-matched biquads (M. Vicanek, "Matched Second Order Digital
+ Filters"). The poles are the exact image of the analog poles (impulse
+ invariance) and the zeros are solved for so the magnitude matches the analog
+ prototype at DC, at the centre frequency and near Nyquist. Unlike the
+ bilinear designs above they don't cramp towards Nyquist, so a 15 kHz peak at
+ 44.1 kHz keeps its analog shape.
+ */
+struct MatchedPoles {
+    double a1, a2;
+};
+
+/** The analog poles mapped through z = exp(s T). */
+template<typename Math>
+MatchedPoles getMatchedPoles(double w0, double Q) {
+    const auto zeta = 1.0 / (2.0 * Q);
+    const auto decay = std::exp(-zeta * w0);
+
+    const auto a1 = zeta <= 1.0
+                        ? -2.0 * decay * Math::cos(std::sqrt(1.0 - zeta * zeta) * w0)
+                        : -2.0 * decay * std::cosh(std::sqrt(zeta * zeta - 1.0) * w0);
+
+    return {a1, decay * decay};
+}
+
+/** Terms of |A(e^jw)|^2 = A0 * phi0 + A1 * phi1 + A2 * phi2 at the centre frequency. */
+struct MatchedBasis {
+    double phi0, phi1, phi2;
+    double A0, A1, A2;
+
+    template<typename Math>
+    static MatchedBasis at(double w0, const MatchedPoles &poles) {
+        const auto s = Math::sin(w0 * 0.5);
+        const auto phi1 = s * s;
+        const auto phi0 = 1.0 - phi1;
+        const auto onePlus = 1.0 + poles.a1 + poles.a2;
+        const auto oneMinus = 1.0 - poles.a1 + poles.a2;
+
+        return {phi0, phi1, 4.0 * phi0 * phi1, onePlus * onePlus, oneMinus * oneMinus, -4.0 * poles.a2};
+    }
+
+    double denominatorSquared() const { return A0 * phi0 + A1 * phi1 + A2 * phi2; }
+};
+
+/** Matched version of makePeakCoefficients, with the same Q and gain conventions. */
+template<typename Math = PreciseMath>
+BiquadCoefficients makeMatchedPeakCoefficients(double sampleRate, double frequency, double Q, double gainFactor) {
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency < sampleRate * 0.5 && Q > 0.0 && gainFactor > 0.0);
+
+    // JUCE's peak has its poles at Q * sqrt(gain), its zeros at Q / sqrt(gain)
+    const auto w0 = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const auto poles = getMatchedPoles<Math>(w0, Q * std::sqrt(gainFactor));
+    const auto basis = MatchedBasis::at<Math>(w0, poles);
+    const auto G2 = gainFactor * gainFactor;
+
+    const auto R1 = basis.denominatorSquared() * G2;
+    const auto R2 = (-basis.A0 + basis.A1 + 4.0 * (basis.phi0 - basis.phi1) * basis.A2) * G2;
+
+    const auto B0 = basis.A0;
+    const auto B2 = (R1 - R2 * basis.phi1 - B0) / (4.0 * basis.phi1 * basis.phi1);
+    const auto B1 = R2 + B0 + 4.0 * (basis.phi1 - basis.phi0) * B2;
+
+    // the squared magnitudes can round slightly below zero for extreme settings
+    const auto sqrtB1 = std::sqrt(juce::jmax(0.0, B1));
+    const auto W = 0.5 * (std::sqrt(B0) + sqrtB1);
+    const auto b0 = 0.5 * (W + std::sqrt(juce::jmax(0.0, W * W + B2)));
+    const auto b1 = 0.5 * (std::sqrt(B0) - sqrtB1);
+
+    return {b0, b1, -B2 / (4.0 * b0), poles.a1, poles.a2};
+}
+
+template<typename Math = PreciseMath>
+BiquadCoefficients makeMatchedHighPassCoefficients(double sampleRate, double frequency, double Q) {
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency < sampleRate * 0.5 && Q > 0.0);
+
+    const auto w0 = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const auto poles = getMatchedPoles<Math>(w0, Q);
+    const auto basis = MatchedBasis::at<Math>(w0, poles);
+
+    const auto b0 = std::sqrt(basis.denominatorSquared()) * Q / (4.0 * basis.phi1);
+
+    return {b0, -2.0 * b0, b0, poles.a1, poles.a2};
+}
+
+template<typename Math = PreciseMath>
+BiquadCoefficients makeMatchedLowPassCoefficients(double sampleRate, double frequency, double Q) {
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency < sampleRate * 0.5 && Q > 0.0);
+
+    const auto w0 = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const auto poles = getMatchedPoles<Math>(w0, Q);
+    const auto basis = MatchedBasis::at<Math>(w0, poles);
+
+    const auto B0 = basis.A0;
+    const auto B1 = (basis.denominatorSquared() * Q * Q - B0 * basis.phi0) / basis.phi1;
+    const auto b0 = 0.5 * (std::sqrt(B0) + std::sqrt(juce::jmax(0.0, B1)));
+
+    return {b0, std::sqrt(B0) - b0, 0.0, poles.a1, poles.a2};
+}
+
+/** Even order Butterworth high pass from matched sections, see designButterworthHighPass. */
+template<int MaxSections, typename Math = PreciseMath>
+CascadeCoefficients<MaxSections> designMatchedButterworthHighPass(double frequency, double sampleRate, int order) {
+    jassert(order > 0 && order % 2 == 0 && order / 2 <= MaxSections);
+
+    CascadeCoefficients<MaxSections> result;
+    result.numSections = order / 2;
+
+    for (int i = 0; i < result.numSections; ++i)
+        result.sections[(size_t) i] = makeMatchedHighPassCoefficients<Math>(sampleRate, frequency,
+                                                                           getButterworthQ<Math>(order, i));
+
+    return result;
+}
+
+/** Even order Butterworth low pass from matched sections, see designButterworthLowPass. */
+template<int MaxSections, typename Math = PreciseMath>
+CascadeCoefficients<MaxSections> designMatchedButterworthLowPass(double frequency, double sampleRate, int order) {
+    jassert(order > 0 && order % 2 == 0 && order / 2 <= MaxSections);
+
+    CascadeCoefficients<MaxSections> result;
+    result.numSections = order / 2;
+
+    for (int i = 0; i < result.numSections; ++i)
+        result.sections[(size_t) i] = makeMatchedLowPassCoefficients<Math>(sampleRate, frequency,
+                                                                          getButterworthQ<Math>(order, i));
+
+    return result;
+}
+
+/**
+ The state variable section with the same response as a (stable) biquad:
+ the biquad is mapped back through the bilinear transform and the analog
+ section is normalised to s^2 + k * s + 1.
+ */
+inline SvfCoefficients makeSvfFromBiquad(const BiquadCoefficients &c) {
+    const auto onePlus = 1.0 + c.a1 + c.a2;
+    const auto oneMinus = 1.0 - c.a1 + c.a2;
+    jassert(onePlus > 0.0 && oneMinus > 0.0);
+
+    const auto g = std::sqrt(onePlus / oneMinus);
+    const auto k = 2.0 * (1.0 - c.a2) * g / onePlus;
+    const auto m0 = (c.b0 - c.b1 + c.b2) * g * g / onePlus;
+    const auto c1 = 2.0 * (c.b0 - c.b2) * g / onePlus;
+    const auto c0 = (c.b0 + c.b1 + c.b2) / onePlus;
+
+    return {g, k, m0, c1 - m0 * k, c0 - m0};
+}
+
+template<int MaxSections>
+CascadeCoefficients<MaxSections, SvfCoefficients> makeSvfFromBiquads(const CascadeCoefficients<MaxSections> &cascade) {
+    CascadeCoefficients<MaxSections, SvfCoefficients> result;
+    result.numSections = cascade.numSections;
+
+    for (int i = 0; i < cascade.numSections; ++i)
+        result.sections[(size_t) i] = makeSvfFromBiquad(cascade[i]);
+
+    return result;
+}
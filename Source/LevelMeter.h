@@ -0,0 +1,266 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+/**
+ Peak, true peak, mean square and overs of one channel.
+
+ The true peak follows ITU-R BS.1770: the signal is upsampled 4x by a
+ 48 tap windowed sinc, split into polyphase branches. Phase 0 of that sinc
+ is the signal itself, so only the three in-between phases are computed,
+ each as 12 vectorized multiply-adds over a tile of samples. Blocks of any
+ size are taken in tiles of tileSize, so the detector holds all its memory
+ itself and never allocates.
+
+ The in-between points come out phaseDelay samples late, so the samples are
+ measured phaseDelay late as well, lined up with them: the last phaseDelay
+ samples of a block count towards the next one.
+ */
+class TruePeakDetector {
+public:
+    static constexpr int factor = 4;
+    static constexpr int tapsPerPhase = 12;
+    static constexpr int tileSize = 256;
+
+    struct Levels {
+        float peak = 0.0f, truePeak = 0.0f;
+        double sumOfSquares = 0.0;
+
+        // samples that are, or are followed by an in-between point that is,
+        // at or over full scale: one per sample, however many of its points are
+        juce::uint32 overs = 0;
+    };
+
+    TruePeakDetector() {
+        // Kaiser windowed sinc with the cutoff at the original Nyquist,
+        // centred on tap 24 so that phase 0 is a plain delay
+        constexpr auto numTaps = factor * tapsPerPhase;
+        constexpr auto centre = numTaps / 2;
+        constexpr auto beta = 6.0;
+
+        auto besselI0 = [](double x) {
+            auto sum = 1.0, term = 1.0;
+            for (int k = 1; k < 32; ++k) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        };
+
+        for (int phase = 1; phase < factor; ++phase) {
+            auto &taps = phaseTaps[(size_t) phase - 1];
+            auto sum = 0.0;
+
+            for (int k = 0; k < tapsPerPhase; ++k) {
+                const auto n = k * factor + phase;
+                const auto x = juce::MathConstants<double>::pi * (n - centre) / factor;
+                const auto position = (double) (n - centre) / centre;
+                const auto window = besselI0(beta * std::sqrt(juce::jmax(0.0, 1.0 - position * position)))
+                                    / besselI0(beta);
+                const auto tap = std::sin(x) / x * window;
+                taps[(size_t) k] = (float) tap;
+                sum += tap;
+            }
+
+            // unity gain at DC for every phase
+            for (auto &tap: taps)
+                tap = (float) (tap / sum);
+        }
+
+        reset();
+    }
+
+    void reset() {
+        std::fill(samples.begin(), samples.end(), 0.0f);
+    }
+
+    template<typename SampleType>
+    Levels process(const SampleType *input, int numSamples) noexcept {
+        Levels levels;
+
+        for (int start = 0; start < numSamples; start += tileSize) {
+            const auto n = juce::jmin(tileSize, numSamples - start);
+            auto *tile = samples.data() + historyLength;
+
+            for (int i = 0; i < n; ++i)
+                tile[i] = (float) input[start + i];
+
+            for (int i = 0; i < n; ++i)
+                levels.sumOfSquares += (double) (tile[i] * tile[i]);
+
+            // the samples the phase outputs below fall after
+            const auto *aligned = tile - phaseDelay;
+
+            auto tilePeak = getAbsoluteMaximum(aligned, n);
+            levels.peak = juce::jmax(levels.peak, tilePeak);
+
+            for (size_t phase = 0; phase < phaseTaps.size(); ++phase) {
+                auto *output = phaseOutputs[phase].data();
+                juce::FloatVectorOperations::multiply(output, tile, phaseTaps[phase][0], n);
+
+                for (int k = 1; k < tapsPerPhase; ++k)
+                    juce::FloatVectorOperations::addWithMultiply(output, tile - k, phaseTaps[phase][(size_t) k], n);
+
+                tilePeak = juce::jmax(tilePeak, getAbsoluteMaximum(output, n));
+            }
+
+            levels.truePeak = juce::jmax(levels.truePeak, tilePeak);
+
+            // the overs are only counted in the rare tiles that have any
+            if (tilePeak >= 1.0f)
+                levels.overs += countOvers(aligned, n);
+
+            std::copy(tile + n - historyLength, tile + n, samples.begin());
+        }
+
+        return levels;
+    }
+
+private:
+    static constexpr int historyLength = tapsPerPhase - 1;
+
+    // phaseOutputs[p][i] is the point (p + 1) / factor after tile[i - phaseDelay],
+    // as the sinc is centred on its middle tap
+    static constexpr int phaseDelay = tapsPerPhase / 2;
+    static_assert(phaseDelay <= historyLength);
+
+    static float getAbsoluteMaximum(const float *data, int n) noexcept {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(data, n);
+        return juce::jmax(-range.getStart(), range.getEnd());
+    }
+
+    juce::uint32 countOvers(const float *aligned, int n) const noexcept {
+        juce::uint32 overs = 0;
+
+        for (int i = 0; i < n; ++i) {
+            auto over = std::abs(aligned[i]) >= 1.0f;
+
+            for (const auto &output: phaseOutputs)
+                over = over || std::abs(output[(size_t) i]) >= 1.0f;
+
+            overs += over ? 1 : 0;
+        }
+
+        return overs;
+    }
+
+    std::array<std::array<float, tapsPerPhase>, factor - 1> phaseTaps{};
+
+    // the last historyLength samples of the previous tile, then the tile
+    std::array<float, historyLength + tileSize> samples{};
+    std::array<std::array<float, tileSize>, factor - 1> phaseOutputs{};
+};
+
+/**
+ Peak, true peak and RMS of a bus, the loudest channel of each, plus a count
+ of overs. The audio thread writes, the editor reads; both sides only touch
+ atomics, so neither ever waits.
+
+ The peaks are held until read: read() takes the highest values since the
+ previous read and starts over, so the editor sees every peak however
+ slowly it polls. The RMS is a running average over rmsSeconds.
+ */
+template<int MaxNumChannels>
+class LevelMeter {
+public:
+    static constexpr double rmsSeconds = 0.3;
+
+    struct Readings {
+        float peak = 0.0f, truePeak = 0.0f, rms = 0.0f;
+        juce::uint32 overs = 0;
+    };
+
+    void prepare(double newSampleRate) {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    void reset() {
+        for (auto &detector: detectors)
+            detector.reset();
+
+        meanSquares.fill(0.0);
+        rms.store(0.0f, std::memory_order_relaxed);
+    }
+
+    /** Audio thread: measures the first numChannels channels of a block. */
+    template<typename SampleType>
+    void process(const juce::AudioBuffer<SampleType> &buffer, int numChannels, int numSamples) noexcept {
+        jassert(numChannels <= MaxNumChannels);
+
+        if (numSamples == 0)
+            return;
+
+        const auto coefficient = 1.0 - std::exp(-numSamples / (rmsSeconds * sampleRate));
+        float blockPeak = 0.0f, blockTruePeak = 0.0f;
+        double loudest = 0.0;
+        juce::uint32 blockOvers = 0;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const auto levels = detectors[(size_t) channel].process(buffer.getReadPointer(channel), numSamples);
+            auto &meanSquare = meanSquares[(size_t) channel];
+            meanSquare += coefficient * (levels.sumOfSquares / numSamples - meanSquare);
+
+            blockPeak = juce::jmax(blockPeak, levels.peak);
+            blockTruePeak = juce::jmax(blockTruePeak, levels.truePeak);
+            loudest = juce::jmax(loudest, meanSquare);
+            blockOvers += levels.overs;
+        }
+
+        publish(blockPeak, blockTruePeak, loudest, blockOvers);
+    }
+
+    /** Audio thread: a block of silence that wasn't processed. */
+    void processSilence(int numSamples) noexcept {
+        const auto decay = std::exp(-numSamples / (rmsSeconds * sampleRate));
+        double loudest = 0.0;
+
+        for (auto &meanSquare: meanSquares) {
+            meanSquare *= decay;
+            loudest = juce::jmax(loudest, meanSquare);
+        }
+
+        for (auto &detector: detectors)
+            detector.reset();
+
+        publish(0.0f, 0.0f, loudest, 0);
+    }
+
+    /** Editor: the peaks since the last call, the current RMS and all overs since resetOvers. */
+    Readings read() noexcept {
+        Readings readings;
+        readings.peak = peak.exchange(0.0f, std::memory_order_relaxed);
+        readings.truePeak = truePeak.exchange(0.0f, std::memory_order_relaxed);
+        readings.rms = rms.load(std::memory_order_relaxed);
+        readings.overs = overs.load(std::memory_order_relaxed);
+        return readings;
+    }
+
+    void resetOvers() noexcept { overs.store(0, std::memory_order_relaxed); }
+
+private:
+    void publish(float blockPeak, float blockTruePeak, double loudest, juce::uint32 blockOvers) noexcept {
+        storeMaximum(peak, blockPeak);
+        storeMaximum(truePeak, blockTruePeak);
+        rms.store((float) std::sqrt(loudest), std::memory_order_relaxed);
+
+        if (blockOvers > 0)
+            overs.fetch_add(blockOvers, std::memory_order_relaxed);
+    }
+
+    static void storeMaximum(std::atomic<float> &target, float value) noexcept {
+        auto current = target.load(std::memory_order_relaxed);
+
+        while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    double sampleRate = 44100.0;
+
+    std::array<TruePeakDetector, MaxNumChannels> detectors;
+    std::array<double, MaxNumChannels> meanSquares{};
+
+    std::atomic<float> peak{0.0f}, truePeak{0.0f}, rms{0.0f};
+    std::atomic<juce::uint32> overs{0};
+};
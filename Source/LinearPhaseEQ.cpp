@@ -0,0 +1,134 @@
+#include "LinearPhaseEQ.h"
+
+LinearPhaseEQ::LinearPhaseEQ() : juce::Thread("Linear phase EQ designer") {
+    startThread();
+}
+
+LinearPhaseEQ::~LinearPhaseEQ() {
+    stopThread(2000);
+}
+
+int LinearPhaseEQ::getKernelLength(double sampleRate) {
+    return juce::nextPowerOfTwo(juce::roundToInt(sampleRate / 6.0));
+}
+
+void LinearPhaseEQ::prepare(const juce::dsp::ProcessSpec &spec) {
+    const juce::ScopedLock lock(designLock);
+
+    numEngines = juce::jmin(maxNumEngines, ((int) spec.numChannels + 1) / 2);
+
+    // the engines past numEngines stay unprepared until a wider bus needs
+    // them; the redesign that follows every prepare loads their kernel
+    const juce::dsp::ProcessSpec pairSpec{spec.sampleRate, spec.maximumBlockSize, 2};
+    for (int engine = 0; engine < numEngines; ++engine)
+        engines[(size_t) engine].prepare(pairSpec);
+
+    sampleRate = spec.sampleRate;
+    kernelLength = getKernelLength(sampleRate);
+    fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(kernelLength)));
+    fftData.assign((size_t) kernelLength * 2, 0.0f);
+
+    // symmetric around the centre tap, which is sample kernelLength / 2
+    window.assign((size_t) kernelLength - 1, 0.0f);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(),
+                                                             juce::dsp::WindowingFunction<float>::blackman,
+                                                             false);
+}
+
+void LinearPhaseEQ::reset() {
+    for (int engine = 0; engine < numEngines; ++engine)
+        engines[(size_t) engine].reset();
+}
+
+bool LinearPhaseEQ::setChainSettings(const ChainSettings &chainSettings) {
+    const juce::SpinLock::ScopedTryLockType lock(settingsLock);
+
+    if (!lock.isLocked())
+        return false;
+
+    pendingSettings = chainSettings;
+    settingsPending = true;
+    return true;
+}
+
+void LinearPhaseEQ::wakeDesigner() {
+    if (settingsPending)
+        notify();
+}
+
+void LinearPhaseEQ::process(const juce::dsp::ProcessContextReplacing<float> &context) {
+    auto &block = context.getOutputBlock();
+    const auto numChannels = (int) block.getNumChannels();
+
+    for (int engine = 0; engine < numEngines && engine * 2 < numChannels; ++engine) {
+        auto pairBlock = block.getSubsetChannelBlock((size_t) engine * 2,
+                                                     (size_t) juce::jmin(2, numChannels - engine * 2));
+        engines[(size_t) engine].process(juce::dsp::ProcessContextReplacing<float>(pairBlock));
+    }
+}
+
+int LinearPhaseEQ::getLatencySamples() const {
+    return kernelLength / 2 + engines[0].getLatency();
+}
+
+void LinearPhaseEQ::run() {
+    while (!threadShouldExit()) {
+        if (settingsPending.exchange(false)) {
+            ChainSettings chainSettings;
+            {
+                const juce::SpinLock::ScopedLockType lock(settingsLock);
+                chainSettings = pendingSettings;
+            }
+
+            designKernel(chainSettings);
+        }
+
+        // the audio thread can't signal us without risking a lock, so the
+        // message thread does it, see wakeDesigner
+        wait(-1);
+    }
+}
+
+void LinearPhaseEQ::designKernel(const ChainSettings &chainSettings) {
+    const juce::ScopedLock lock(designLock);
+
+    if (fft == nullptr)
+        return;
+
+    updateMonoChain(designChain, chainSettings, sampleRate);
+
+    // A real, zero phase spectrum, so the inverse transform is symmetric
+    // around sample 0. Its mean is the value of that centre tap, which pins
+    // the scale whatever normalisation the FFT backend uses.
+    std::fill(fftData.begin(), fftData.end(), 0.0f);
+
+    const auto numBins = kernelLength / 2 + 1;
+    double centreTap = 0.0;
+
+    for (int bin = 0; bin < numBins; ++bin) {
+        const auto frequency = bin * sampleRate / kernelLength;
+        const auto magnitude = getMagnitudeForFrequency(designChain, frequency, sampleRate);
+        fftData[(size_t) bin * 2] = (float) magnitude;
+        centreTap += (bin == 0 || bin == numBins - 1) ? magnitude : 2.0 * magnitude;
+    }
+
+    centreTap /= kernelLength;
+
+    fft->performRealOnlyInverseTransform(fftData.data());
+
+    const auto scale = fftData[0] != 0.0f ? (float) (centreTap / fftData[0]) : 0.0f;
+
+    // rotate the centre to kernelLength / 2 and window the tails off
+    juce::AudioBuffer<float> kernel(1, kernelLength);
+    auto *taps = kernel.getWritePointer(0);
+    taps[0] = 0.0f;
+
+    for (int n = 1; n < kernelLength; ++n)
+        taps[n] = fftData[(size_t) ((n + kernelLength / 2) % kernelLength)] * scale * window[(size_t) n - 1];
+
+    for (int engine = 0; engine < numEngines; ++engine)
+        engines[(size_t) engine].loadImpulseResponse(juce::AudioBuffer<float>(kernel), sampleRate,
+                                                     juce::dsp::Convolution::Stereo::no,
+                                                     juce::dsp::Convolution::Trim::no,
+                                                     juce::dsp::Convolution::Normalise::no);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+/**
+ Linear phase version of the low cut / peak / high cut chain. The magnitude
+ response of the regular designs is turned into a symmetric FIR and run with
+ uniformly partitioned FFT convolution.
+
+ The kernel has to be long to resolve bass frequencies, so designing it takes
+ an FFT of several thousand points and happens on a background thread. The
+ audio thread only hands over the latest settings, and the message thread
+ wakes the designer for them; juce::dsp::Convolution then crossfades from
+ the old kernel to the new one. Without settings to design, the designer
+ sleeps, so it costs nothing in minimum phase mode.
+ */
+class LinearPhaseEQ : private juce::Thread {
+public:
+    LinearPhaseEQ();
+
+    ~LinearPhaseEQ() override;
+
+    void prepare(const juce::dsp::ProcessSpec &spec);
+
+    void reset();
+
+    /**
+     Queues a redesign for the given settings. Never blocks: returns false if
+     the designer was busy picking up the previous settings, in which case
+     the caller should try again later.
+     */
+    bool setChainSettings(const ChainSettings &chainSettings);
+
+    /** Message thread: wakes the designer if setChainSettings left it anything to do. */
+    void wakeDesigner();
+
+    void process(const juce::dsp::ProcessContextReplacing<float> &context);
+
+    /** The kernel is centred on its middle tap, on top of the engine's own latency. */
+    int getLatencySamples() const;
+
+    /** Kernel length for a sample rate: long enough for ~6 Hz resolution. */
+    static int getKernelLength(double sampleRate);
+
+private:
+    void run() override;
+
+    void designKernel(const ChainSettings &chainSettings);
+
+    // juce::dsp::Convolution handles at most two channels, so wider buses run
+    // one engine per pair of channels.
+    static constexpr int maxNumEngines = (BassQualizerAudioProcessor::maxNumChannels + 1) / 2;
+    std::array<juce::dsp::Convolution, maxNumEngines> engines;
+    int numEngines = 0;
+
+    juce::SpinLock settingsLock;
+    ChainSettings pendingSettings;
+    std::atomic<bool> settingsPending{false};
+
+    // Everything below belongs to the designer thread; prepare() takes the
+    // lock to change it.
+    juce::CriticalSection designLock;
+    double sampleRate = 0.0;
+    int kernelLength = 0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftData, window;
+    MonoChain designChain;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LinearPhaseEQ)
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadCascade.h"
+
+/**
+ Running K-weighted loudness of the plugin's input and output, and the gain
+ that brings the output back to the loudness of the input.
+
+ Input and output share the SIMD registers: the lower half of the lanes
+ holds input channels and the upper half the same output channels, so a
+ single K-weighting pass per block measures both. That pass runs at half
+ the sample rate, on the mean of each pair of samples, which halves its cost.
+ Half the difference of each pair carries the rest of the energy, mostly
+ from above a quarter of the sample rate, where the K-weighting is flat at
+ its top shelf gain: its square is counted at that weight without filtering.
+ Each block's mean square (summed over the channels, as in BS.1770) feeds an
+ exponential average with a time constant of averagingSeconds.
+ */
+template<int MaxNumChannels>
+class LoudnessMatch {
+public:
+    using Vector = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int numLanes = (int) Vector::size();
+    static constexpr int channelsPerGroup = numLanes / 2;
+    static constexpr int maxGroups = (MaxNumChannels + channelsPerGroup - 1) / channelsPerGroup;
+
+    static constexpr double averagingSeconds = 1.5;
+
+    /** Input samples per K-weighted frame. */
+    static constexpr int decimation = 2;
+
+    /** The largest correction either way. */
+    static constexpr float maxGainDecibels = 24.0f;
+
+    void prepare(double newSampleRate, int maximumBlockSize) {
+        sampleRate = newSampleRate;
+
+        const auto maxFrames = juce::jmax(1, maximumBlockSize / decimation);
+        frameBlock = juce::dsp::AudioBlock<Vector>(frameStorage, (size_t) maxGroups, (size_t) maxFrames);
+        frameBlock.clear();
+
+        // the shelf's gain at the full rate's Nyquist frequency
+        const auto fullRateShelf = makeKWeightingShelfCoefficients(sampleRate);
+        const auto topGain = (fullRateShelf.b0 - fullRateShelf.b1 + fullRateShelf.b2)
+                             / (1.0 - fullRateShelf.a1 + fullRateShelf.a2);
+        differenceWeight = topGain * topGain;
+
+        const auto frameRate = sampleRate / decimation;
+        const auto shelf = makeKWeightingShelfCoefficients(frameRate);
+        const auto highPass = makeKWeightingHighPassCoefficients(frameRate);
+
+        for (auto &filter: kWeighting) {
+            filter.prepare({frameRate, (juce::uint32) maxFrames, 1});
+            filter.setSection(0, shelf);
+            filter.setSection(1, highPass);
+            filter.setNumActiveStages(2);
+        }
+
+        reset();
+    }
+
+    void reset() {
+        for (auto &filter: kWeighting)
+            filter.reset();
+
+        inputPower = outputPower = 0.0;
+        inputDifferenceSum = 0.0;
+        gainDecibels = 0.0f;
+    }
+
+    /** Takes the input of a block; call before processing it. */
+    template<typename SampleType>
+    void pushInput(const juce::AudioBuffer<SampleType> &buffer, int numChannels, int numSamples) noexcept {
+        inputDifferenceSum = copyToLanes(buffer, numChannels, numSamples, 0);
+    }
+
+    /** Takes the output of the same block and updates the measurement. */
+    template<typename SampleType>
+    void pushOutput(const juce::AudioBuffer<SampleType> &buffer, int numChannels, int numSamples) noexcept {
+        const auto outputDifferenceSum = copyToLanes(buffer, numChannels, numSamples, channelsPerGroup);
+        measure(numChannels, numSamples, outputDifferenceSum);
+    }
+
+    /** Input minus output loudness. Kept while either side is below the -70 LUFS gate. */
+    float getGainDecibels() const noexcept { return gainDecibels; }
+
+private:
+    // -70 LUFS, the absolute gate of BS.1770, as a mean square
+    static constexpr double gatePower = 1.1724653045822963e-7;
+
+    /**
+     Writes the pair means to the lanes and returns the sum of the squared
+     half differences. An odd last sample of a block is left out.
+     */
+    template<typename SampleType>
+    double copyToLanes(const juce::AudioBuffer<SampleType> &buffer, int numChannels, int numSamples,
+                       int firstLane) noexcept {
+        const auto numFrames = numSamples / decimation;
+        jassert(numFrames <= (int) frameBlock.getNumSamples());
+        jassert(numChannels <= MaxNumChannels);
+
+        double differenceSum = 0.0;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const auto lane = firstLane + channel % channelsPerGroup;
+            auto *frames = reinterpret_cast<float *>(frameBlock.getChannelPointer((size_t) (channel / channelsPerGroup)));
+            const auto *source = buffer.getReadPointer(channel);
+            auto squares = 0.0f;
+
+            for (int i = 0; i < numFrames; ++i) {
+                const auto first = (float) source[2 * i], second = (float) source[2 * i + 1];
+                const auto difference = 0.5f * (first - second);
+
+                frames[i * numLanes + lane] = 0.5f * (first + second);
+                squares += difference * difference;
+            }
+
+            differenceSum += squares;
+        }
+
+        return differenceSum;
+    }
+
+    void measure(int numChannels, int numSamples, double outputDifferenceSum) noexcept {
+        const auto numFrames = numSamples / decimation;
+
+        if (numChannels == 0 || numFrames == 0)
+            return;
+
+        const auto numGroups = (numChannels + channelsPerGroup - 1) / channelsPerGroup;
+        auto inputSum = differenceWeight * inputDifferenceSum;
+        auto outputSum = differenceWeight * outputDifferenceSum;
+
+        for (int group = 0; group < numGroups; ++group) {
+            auto block = frameBlock.getSingleChannelBlock((size_t) group).getSubBlock(0, (size_t) numFrames);
+            kWeighting[(size_t) group].process(juce::dsp::ProcessContextReplacing<Vector>(block));
+
+            const auto *frames = block.getChannelPointer(0);
+            auto squares = Vector::expand(0.0f);
+
+            for (int i = 0; i < numFrames; ++i)
+                squares += frames[i] * frames[i];
+
+            const auto channelsInGroup = juce::jmin(channelsPerGroup, numChannels - group * channelsPerGroup);
+
+            for (int lane = 0; lane < channelsInGroup; ++lane) {
+                inputSum += squares.get((size_t) lane);
+                outputSum += squares.get((size_t) (lane + channelsPerGroup));
+            }
+        }
+
+        const auto coefficient = 1.0 - std::exp(-numSamples / (averagingSeconds * sampleRate));
+        inputPower += coefficient * (inputSum / numFrames - inputPower);
+        outputPower += coefficient * (outputSum / numFrames - outputPower);
+
+        if (inputPower > gatePower && outputPower > gatePower)
+            gainDecibels = juce::jlimit(-maxGainDecibels, maxGainDecibels,
+                                        (float) (10.0 * std::log10(inputPower / outputPower)));
+    }
+
+    double sampleRate = 44100.0;
+
+    std::array<BiquadCascade<Vector, 2>, maxGroups> kWeighting;
+
+    juce::HeapBlock<char> frameStorage;
+    juce::dsp::AudioBlock<Vector> frameBlock;
+
+    // weight of the squared half differences, and their sum for the block's input
+    double differenceWeight = 1.0, inputDifferenceSum = 0.0;
+
+    double inputPower = 0.0, outputPower = 0.0;
+    float gainDecibels = 0.0f;
+};
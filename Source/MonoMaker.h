@@ -0,0 +1,100 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadCascade.h"
+
+/**
+ Sums the lows of each channel pair to mono and leaves the highs alone.
+
+ The crossover is a 4th order Linkwitz-Riley: its low band is a Butterworth
+ low pass run twice, and low plus high band is a 2nd order allpass. So
+ instead of splitting and summing, each lane runs that allpass and only the
+ part of the low band that differs between the two channels is taken away:
+
+     left'  = allpass(left)  - low((left - right) / 2)
+     right' = allpass(right) + low((left - right) / 2)
+
+ The highs come out exactly as the LR4 high band would, and the lows as its
+ low band summed to mono, with the same phase as the highs.
+
+ Processes one group of interleaved channels, where the lane pairs 0/1, 2/3,
+ ... are the channel pairs. The filters are the BiquadCascades the chains
+ use; only the pair mixing works on single lanes.
+ */
+template<typename SampleType>
+class MonoMaker {
+public:
+    static constexpr double crossoverQ = 0.7071067811865476;
+
+    void prepare(const juce::dsp::ProcessSpec &spec) {
+        jassert(spec.numChannels == 1);
+
+        lowBlock = juce::dsp::AudioBlock<SampleType>(lowStorage, 1, (size_t) spec.maximumBlockSize);
+        lowPass.prepare(spec);
+        allPass.prepare(spec);
+        lowPass.setNumActiveStages(2);
+        allPass.setNumActiveStages(1);
+    }
+
+    void reset() {
+        lowPass.reset();
+        allPass.reset();
+    }
+
+    template<typename Math = PreciseMath>
+    void setCrossover(double sampleRate, double frequency) {
+        const auto lowPassSection = makeLowPassCoefficients<Math>(sampleRate, frequency, crossoverQ);
+        lowPass.setSection(0, lowPassSection);
+        lowPass.setSection(1, lowPassSection);
+        allPass.setSection(0, makeAllPassCoefficients<Math>(sampleRate, frequency, crossoverQ));
+    }
+
+    /**
+     Mixes the first numPairs lane pairs; any other lane only gets the
+     allpass. With midSide the pairs hold mid and side, and the side loses
+     its lows instead.
+     */
+    void process(const juce::dsp::ProcessContextReplacing<SampleType> &context, int numPairs, bool midSide) noexcept {
+        using Element = typename SampleType::ElementType;
+        constexpr auto numLanes = SampleType::size();
+
+        auto &block = context.getOutputBlock();
+        const auto numSamples = block.getNumSamples();
+        jassert(numSamples <= lowBlock.getNumSamples());
+        jassert(numPairs * 2 <= (int) numLanes);
+
+        auto low = lowBlock.getSubBlock(0, numSamples);
+        std::copy(block.getChannelPointer(0), block.getChannelPointer(0) + numSamples, low.getChannelPointer(0));
+
+        lowPass.process(juce::dsp::ProcessContextReplacing<SampleType>(low));
+        allPass.process(context);
+
+        auto *output = reinterpret_cast<Element *>(block.getChannelPointer(0));
+        auto *lows = reinterpret_cast<const Element *>(low.getChannelPointer(0));
+        const auto half = Element(0.5);
+
+        for (size_t i = 0; i < numSamples; ++i) {
+            auto *frame = output + i * numLanes;
+            auto *lowFrame = lows + i * numLanes;
+
+            for (int pair = 0; pair < numPairs; ++pair) {
+                const auto first = (size_t) (pair * 2), second = first + 1;
+
+                if (midSide) {
+                    frame[second] -= lowFrame[second];
+                } else {
+                    const auto difference = half * (lowFrame[first] - lowFrame[second]);
+                    frame[first] -= difference;
+                    frame[second] += difference;
+                }
+            }
+        }
+    }
+
+private:
+    BiquadCascade<SampleType, 2> lowPass;
+    BiquadCascade<SampleType, 1> allPass;
+
+    juce::HeapBlock<char> lowStorage;
+    juce::dsp::AudioBlock<SampleType> lowBlock;
+};
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SvfCascade.h"
+
+/**
+ Runs a low frequency cascade at a fraction of the sample rate.
+
+ The input is decimated by a polyphase FIR, the cascade runs on the
+ decimated signal, and only the difference it makes (output minus input) is
+ interpolated back and added to the delayed full rate signal:
+
+     y = delay(x) + interpolate(cascade(d) - d),   d = decimate(x)
+
+ With the cascade switched off this is exactly the delayed input, so the
+ decimation and interpolation filters never colour the rest of the
+ spectrum; they only have to be good where the cascade changes the signal.
+ The low band always uses state variable sections: at the reduced rate their
+ poles are far enough from z = 1 to stay accurate under modulation.
+
+ Like the filter cascades, one band processes one channel, or one group of
+ interleaved channels when SampleType is a SIMDRegister.
+ */
+template<typename SampleType>
+class MultirateBand {
+public:
+    using Cascade = SvfCascade<SampleType, 4>;
+
+    static constexpr int tapsPerPhase = 12;
+    static constexpr int maxFactor = 16;
+
+    /** The largest power of two (up to maxFactor) that keeps the band at 11 kHz or more. */
+    static int getFactorForSampleRate(double sampleRate) {
+        int factor = 1;
+
+        while (factor < maxFactor && sampleRate / (factor * 2) >= 11025.0)
+            factor *= 2;
+
+        return factor;
+    }
+
+    void prepare(double sampleRate, int maximumBlockSize) {
+        factor = getFactorForSampleRate(sampleRate);
+        kernelLength = tapsPerPhase * factor;
+
+        // windowed sinc at the Nyquist frequency of the decimated band; what
+        // aliases into the transition band is left alone by the cascade
+        std::vector<float> window((size_t) kernelLength);
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(),
+                                                                 juce::dsp::WindowingFunction<float>::kaiser,
+                                                                 false, 7.0f);
+
+        std::vector<double> kernel((size_t) kernelLength);
+        const auto cutoff = 0.5 / factor;
+        const auto centre = 0.5 * (kernelLength - 1);
+        double sum = 0.0;
+
+        for (int j = 0; j < kernelLength; ++j) {
+            const auto t = j - centre;
+            const auto x = juce::MathConstants<double>::twoPi * cutoff * t;
+            kernel[(size_t) j] = 2.0 * cutoff * (std::sin(x) / x) * window[(size_t) j];
+            sum += kernel[(size_t) j];
+        }
+
+        // decimation taps are stored newest first, interpolation taps by phase
+        decimationTaps.resize((size_t) kernelLength);
+        interpolationTaps.resize((size_t) kernelLength);
+
+        for (int j = 0; j < kernelLength; ++j)
+            decimationTaps[(size_t) j] = (float) (kernel[(size_t) j] / sum);
+
+        for (int phase = 0; phase < factor; ++phase)
+            for (int q = 0; q < tapsPerPhase; ++q)
+                interpolationTaps[(size_t) (phase * tapsPerPhase + q)] =
+                        (float) (factor * kernel[(size_t) (phase + q * factor)] / sum);
+
+        // both histories are stored twice so every read is contiguous
+        inputHistory.assign((size_t) kernelLength * 2, broadcast<SampleType>(0));
+        differenceHistory.assign((size_t) tapsPerPhase * 2, broadcast<SampleType>(0));
+        delayLine.assign((size_t) getLatencySamples(), broadcast<SampleType>(0));
+
+        lowRateInput.assign((size_t) (maximumBlockSize / factor + 1), broadcast<SampleType>(0));
+        lowRateOutput.assign(lowRateInput.size(), broadcast<SampleType>(0));
+
+        cascade.prepare({sampleRate / factor, (juce::uint32) lowRateInput.size(), 1});
+        reset();
+    }
+
+    void reset() {
+        std::fill(inputHistory.begin(), inputHistory.end(), broadcast<SampleType>(0));
+        std::fill(differenceHistory.begin(), differenceHistory.end(), broadcast<SampleType>(0));
+        std::fill(delayLine.begin(), delayLine.end(), broadcast<SampleType>(0));
+        inputPosition = differencePosition = delayPosition = 0;
+        decimationPhase = interpolationPhase = 0;
+        cascade.reset();
+    }
+
+    int getFactor() const { return factor; }
+
+    /** The delay of the decimation and interpolation filters together. */
+    int getLatencySamples() const { return kernelLength - 1; }
+
+    Cascade &getCascade() { return cascade; }
+
+    /**
+     An inactive band only delays the signal, so the latency doesn't depend on
+     whether the cascade currently has anything to do. Activating it starts
+     the low band from silence.
+     */
+    void setActive(bool shouldBeActive) {
+        if (shouldBeActive && !active) {
+            std::fill(inputHistory.begin(), inputHistory.end(), broadcast<SampleType>(0));
+            std::fill(differenceHistory.begin(), differenceHistory.end(), broadcast<SampleType>(0));
+            cascade.reset();
+        }
+
+        active = shouldBeActive;
+    }
+
+    void process(const juce::dsp::ProcessContextReplacing<SampleType> &context) noexcept {
+        auto &block = context.getOutputBlock();
+        jassert(block.getNumChannels() == 1);
+
+        auto *samples = block.getChannelPointer(0);
+        const auto numSamples = (int) block.getNumSamples();
+
+        if (!active) {
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] = delay(samples[i]);
+
+            return;
+        }
+
+        const auto numLowRate = decimate(samples, numSamples);
+
+        auto *lowRateData = lowRateOutput.data();
+        std::copy(lowRateInput.begin(), lowRateInput.begin() + numLowRate, lowRateOutput.begin());
+        juce::dsp::AudioBlock<SampleType> lowRateBlock(&lowRateData, 1, (size_t) numLowRate);
+        cascade.process(juce::dsp::ProcessContextReplacing<SampleType>(lowRateBlock));
+
+        for (int k = 0; k < numLowRate; ++k)
+            lowRateOutput[(size_t) k] = lowRateOutput[(size_t) k] - lowRateInput[(size_t) k];
+
+        interpolate(samples, numSamples);
+    }
+
+private:
+    SampleType delay(SampleType input) noexcept {
+        const auto output = delayLine[(size_t) delayPosition];
+        delayLine[(size_t) delayPosition] = input;
+        delayPosition = (delayPosition + 1) % (int) delayLine.size();
+        return output;
+    }
+
+    /** Fills lowRateInput with every factor-th filtered sample, returns how many. */
+    int decimate(const SampleType *input, int numSamples) noexcept {
+        int numLowRate = 0;
+
+        for (int i = 0; i < numSamples; ++i) {
+            inputPosition = (inputPosition == 0 ? kernelLength : inputPosition) - 1;
+            inputHistory[(size_t) inputPosition] = inputHistory[(size_t) (inputPosition + kernelLength)] = input[i];
+
+            if (decimationPhase == 0) {
+                const auto *history = inputHistory.data() + inputPosition;
+                auto sum = broadcast<SampleType>(0);
+
+                for (int j = 0; j < kernelLength; ++j)
+                    sum += history[j] * decimationTaps[(size_t) j];
+
+                lowRateInput[(size_t) numLowRate++] = sum;
+            }
+
+            decimationPhase = (decimationPhase + 1) % factor;
+        }
+
+        return numLowRate;
+    }
+
+    /** Adds the interpolated low band difference to the delayed input. */
+    void interpolate(SampleType *samples, int numSamples) noexcept {
+        int k = 0;
+
+        for (int i = 0; i < numSamples; ++i) {
+            if (interpolationPhase == 0) {
+                differencePosition = (differencePosition == 0 ? tapsPerPhase : differencePosition) - 1;
+                differenceHistory[(size_t) differencePosition]
+                        = differenceHistory[(size_t) (differencePosition + tapsPerPhase)]
+                        = lowRateOutput[(size_t) k++];
+            }
+
+            const auto *history = differenceHistory.data() + differencePosition;
+            const auto *taps = interpolationTaps.data() + interpolationPhase * tapsPerPhase;
+            auto sum = broadcast<SampleType>(0);
+
+            for (int q = 0; q < tapsPerPhase; ++q)
+                sum += history[q] * taps[q];
+
+            samples[i] = delay(samples[i]) + sum;
+            interpolationPhase = (interpolationPhase + 1) % factor;
+        }
+    }
+
+    int factor = 1, kernelLength = tapsPerPhase;
+    bool active = false;
+
+    std::vector<float> decimationTaps, interpolationTaps;
+    std::vector<SampleType> inputHistory, differenceHistory, delayLine;
+    std::vector<SampleType> lowRateInput, lowRateOutput;
+    int inputPosition = 0, differencePosition = 0, delayPosition = 0;
+    int decimationPhase = 0, interpolationPhase = 0;
+
+    Cascade cascade;
+};
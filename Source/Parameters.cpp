@@ -0,0 +1,39 @@
+#include "Parameters.h"
+
+juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout() {
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    for (const auto &descriptor: parameterDescriptors) {
+        switch (descriptor.type) {
+            case ParameterType::Float:
+                layout.add(std::make_unique<juce::AudioParameterFloat>(
+                    descriptor.id, descriptor.name,
+                    juce::NormalisableRange<float>(descriptor.minimum, descriptor.maximum,
+                                                   descriptor.interval, descriptor.skew),
+                    descriptor.defaultValue));
+                break;
+            case ParameterType::Choice: {
+                juce::StringArray choices;
+                for (int i = 0; i < descriptor.numChoices; ++i)
+                    choices.add(descriptor.choices[i]);
+
+                layout.add(std::make_unique<juce::AudioParameterChoice>(
+                    descriptor.id, descriptor.name, choices, (int) descriptor.defaultValue));
+                break;
+            }
+            case ParameterType::Bool:
+                layout.add(std::make_unique<juce::AudioParameterBool>(
+                    descriptor.id, descriptor.name, descriptor.defaultValue > 0.5f));
+                break;
+        }
+    }
+
+    return layout;
+}
+
+ParameterHandles::ParameterHandles(juce::AudioProcessorValueTreeState &apvts) {
+    for (const auto &descriptor: parameterDescriptors) {
+        values[(size_t) descriptor.param] = apvts.getRawParameterValue(descriptor.id);
+        jassert(values[(size_t) descriptor.param] != nullptr);
+    }
+}
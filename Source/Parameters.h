@@ -0,0 +1,314 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** The parameters of one band of the band bank, in the order they repeat per band. */
+enum class BandParam {
+    active,
+    type,
+    freq,
+    gain,
+    quality,
+
+    numBandParams
+};
+
+inline constexpr int numBands = 16;
+
+/**
+ Every parameter of the plugin. The order matches parameterDescriptors below,
+ so a Param can be used directly as an index into the table and into
+ ParameterHandles.
+ */
+enum class Param {
+    lowCutFreq,
+    highCutFreq,
+    peakFreq,
+    peakGainInDb,
+    peakQuality,
+    lowCutSlope,
+    highCutSlope,
+    lowCutBypass,
+    peakBypass,
+    highCutBypass,
+    reverbRoomSize,
+    reverbDamping,
+    reverbWetLevel,
+    reverbDryLevel,
+    reverbWidth,
+    reverbFreezeMode,
+    reverbBypass,
+    filterTopology,
+    lfoRate,
+    lfoDepth,
+    lfoShape,
+    lfoTarget,
+    lfoAudioRate,
+    phaseMode,
+    designMethod,
+    multirateBass,
+    reverbEngine,
+    fdnHalfRate,
+    peakDynamic,
+    peakThreshold,
+    peakRatio,
+    peakAttack,
+    peakRelease,
+    peakSidechain,
+    stereoMode,
+    // the cuts and peak of the second channel of each pair (right or side)
+    // when the stereo mode isn't linked
+    lowCutFreq2,
+    highCutFreq2,
+    peakFreq2,
+    peakGainInDb2,
+    peakQuality2,
+    lowCutSlope2,
+    highCutSlope2,
+    lowCutBypass2,
+    peakBypass2,
+    highCutBypass2,
+    monoBass,
+    monoBassFreq,
+    autoGain,
+    autoGainFreeze,
+
+    // numBands blocks of BandParam::numBandParams parameters, see getBandParam
+    firstBandParam,
+
+    numParameters = firstBandParam + numBands * (int) BandParam::numBandParams
+};
+
+constexpr Param getBandParam(int band, BandParam bandParam) {
+    return static_cast<Param>((int) Param::firstBandParam + band * (int) BandParam::numBandParams + (int) bandParam);
+}
+
+enum class ParameterType {
+    Float,
+    Choice,
+    Bool
+};
+
+inline constexpr const char *slopeChoices[] = {"12 db/Oct", "24 db/Oct", "36 db/Oct", "48 db/Oct"};
+
+inline constexpr const char *filterTopologyChoices[] = {"Biquad", "State Variable"};
+
+inline constexpr const char *lfoShapeChoices[] = {"Sine", "Triangle", "Saw", "Square"};
+
+inline constexpr const char *lfoTargetChoices[] = {"LFO Off", "Peak Freq", "Low Cut Freq", "High Cut Freq"};
+
+inline constexpr const char *phaseModeChoices[] = {"Minimum Phase", "Linear Phase"};
+
+inline constexpr const char *designMethodChoices[] = {"Bilinear", "Matched"};
+
+inline constexpr const char *bandTypeChoices[] = {"Peak", "Low Shelf", "High Shelf", "Notch", "Low Cut", "High Cut"};
+
+inline constexpr const char *stereoModeChoices[] = {"Linked", "Left/Right", "Mid/Side"};
+
+inline constexpr const char *reverbEngineChoices[] = {"Algorithmic", "Convolution", "FDN"};
+
+struct ParameterDescriptor {
+    Param param;
+    const char *id;
+    const char *name;
+    ParameterType type;
+
+    // Float: range and default. Choice: default index. Bool: default as 0/1.
+    float minimum, maximum, interval, skew, defaultValue;
+
+    const char *const *choices;
+    int numChoices;
+};
+
+constexpr ParameterDescriptor makeFloat(Param param, const char *id, const char *name,
+                                        float minimum, float maximum, float defaultValue,
+                                        float interval = 0.0f, float skew = 1.0f) {
+    return {param, id, name, ParameterType::Float, minimum, maximum, interval, skew, defaultValue, nullptr, 0};
+}
+
+template<int NumChoices>
+constexpr ParameterDescriptor makeChoice(Param param, const char *id, const char *name,
+                                         const char *const (&choices)[NumChoices], int defaultIndex) {
+    return {
+        param, id, name, ParameterType::Choice, 0.0f, float(NumChoices - 1), 1.0f, 1.0f, float(defaultIndex),
+        choices, NumChoices
+    };
+}
+
+constexpr ParameterDescriptor makeBool(Param param, const char *id, const char *name, bool defaultValue) {
+    return {param, id, name, ParameterType::Bool, 0.0f, 1.0f, 1.0f, 1.0f, defaultValue ? 1.0f : 0.0f, nullptr, 0};
+}
+
+inline constexpr std::array<ParameterDescriptor, (size_t) Param::firstBandParam> fixedParameterDescriptors{
+    {
+        makeFloat(Param::lowCutFreq, "lowCutFreq", "Low Cut Freq", 20.0f, 20000.0f, 20.0f, 1.0f, 0.25f),
+        makeFloat(Param::highCutFreq, "highCutFreq", "High Cut Freq", 20.0f, 20000.0f, 20000.0f, 1.0f, 0.25f),
+        makeFloat(Param::peakFreq, "peakFreq", "Peak Freq", 20.0f, 20000.0f, 750.0f, 1.0f, 0.25f),
+        makeFloat(Param::peakGainInDb, "peakGainInDb", "Peak Gain", -24.0f, 24.0f, 0.0f),
+        makeFloat(Param::peakQuality, "peakQuality", "Peak Quality", 0.1f, 10.0f, 1.0f),
+        makeChoice(Param::lowCutSlope, "lowCutSlope", "Low Cut Slope", slopeChoices, 0),
+        makeChoice(Param::highCutSlope, "highCutSlope", "High Cut Slope", slopeChoices, 0),
+        makeBool(Param::lowCutBypass, "lowCutBypass", "Low Cut Bypass", false),
+        makeBool(Param::peakBypass, "peakBypass", "Peak Bypass", false),
+        makeBool(Param::highCutBypass, "highCutBypass", "High Cut Bypass", false),
+        makeFloat(Param::reverbRoomSize, "reverbRoomSize", "Room Size", 0.0f, 1.0f, 0.5f),
+        makeFloat(Param::reverbDamping, "reverbDamping", "Damping", 0.0f, 1.0f, 0.5f),
+        makeFloat(Param::reverbWetLevel, "reverbWetLevel", "Wet Level", 0.0f, 1.0f, 0.33f),
+        makeFloat(Param::reverbDryLevel, "reverbDryLevel", "Dry Level", 0.0f, 1.0f, 0.4f),
+        makeFloat(Param::reverbWidth, "reverbWidth", "Width", 0.0f, 1.0f, 1.0f),
+        makeBool(Param::reverbFreezeMode, "reverbFreezeMode", "Freeze Mode", false),
+        makeBool(Param::reverbBypass, "reverbBypass", "Reverb Bypass", true),
+        makeChoice(Param::filterTopology, "filterTopology", "Filter Topology", filterTopologyChoices, 0),
+        makeFloat(Param::lfoRate, "lfoRate", "LFO Rate", 0.01f, 20.0f, 1.0f, 0.01f, 0.3f),
+        makeFloat(Param::lfoDepth, "lfoDepth", "LFO Depth", 0.0f, 4.0f, 1.0f),
+        makeChoice(Param::lfoShape, "lfoShape", "LFO Shape", lfoShapeChoices, 0),
+        makeChoice(Param::lfoTarget, "lfoTarget", "LFO Target", lfoTargetChoices, 0),
+        makeBool(Param::lfoAudioRate, "lfoAudioRate", "LFO Audio Rate", false),
+        makeChoice(Param::phaseMode, "phaseMode", "Phase Mode", phaseModeChoices, 0),
+        makeChoice(Param::designMethod, "designMethod", "Design Method", designMethodChoices, 0),
+        makeBool(Param::multirateBass, "multirateBass", "Multirate Bass", false),
+        makeChoice(Param::reverbEngine, "reverbEngine", "Reverb Engine", reverbEngineChoices, 0),
+        makeBool(Param::fdnHalfRate, "fdnHalfRate", "FDN Half Rate", false),
+        makeBool(Param::peakDynamic, "peakDynamic", "Peak Dynamic", false),
+        makeFloat(Param::peakThreshold, "peakThreshold", "Peak Threshold", -60.0f, 0.0f, -24.0f, 0.1f),
+        makeFloat(Param::peakRatio, "peakRatio", "Peak Ratio", 1.0f, 20.0f, 4.0f, 0.1f, 0.4f),
+        makeFloat(Param::peakAttack, "peakAttack", "Peak Attack", 0.1f, 100.0f, 10.0f, 0.1f, 0.4f),
+        makeFloat(Param::peakRelease, "peakRelease", "Peak Release", 5.0f, 1000.0f, 100.0f, 1.0f, 0.4f),
+        makeBool(Param::peakSidechain, "peakSidechain", "Peak Sidechain", false),
+        makeChoice(Param::stereoMode, "stereoMode", "Stereo Mode", stereoModeChoices, 0),
+        makeFloat(Param::lowCutFreq2, "lowCutFreq2", "Low Cut Freq 2", 20.0f, 20000.0f, 20.0f, 1.0f, 0.25f),
+        makeFloat(Param::highCutFreq2, "highCutFreq2", "High Cut Freq 2", 20.0f, 20000.0f, 20000.0f, 1.0f, 0.25f),
+        makeFloat(Param::peakFreq2, "peakFreq2", "Peak Freq 2", 20.0f, 20000.0f, 750.0f, 1.0f, 0.25f),
+        makeFloat(Param::peakGainInDb2, "peakGainInDb2", "Peak Gain 2", -24.0f, 24.0f, 0.0f),
+        makeFloat(Param::peakQuality2, "peakQuality2", "Peak Quality 2", 0.1f, 10.0f, 1.0f),
+        makeChoice(Param::lowCutSlope2, "lowCutSlope2", "Low Cut Slope 2", slopeChoices, 0),
+        makeChoice(Param::highCutSlope2, "highCutSlope2", "High Cut Slope 2", slopeChoices, 0),
+        makeBool(Param::lowCutBypass2, "lowCutBypass2", "Low Cut Bypass 2", false),
+        makeBool(Param::peakBypass2, "peakBypass2", "Peak Bypass 2", false),
+        makeBool(Param::highCutBypass2, "highCutBypass2", "High Cut Bypass 2", false),
+        makeBool(Param::monoBass, "monoBass", "Mono Bass", false),
+        makeFloat(Param::monoBassFreq, "monoBassFreq", "Mono Bass Freq", 20.0f, 500.0f, 120.0f, 1.0f, 0.5f),
+        makeBool(Param::autoGain, "autoGain", "Auto Gain", false),
+        makeBool(Param::autoGainFreeze, "autoGainFreeze", "Auto Gain Freeze", false),
+    }
+};
+
+/** Ids ("band1Freq") and names ("Band 1 Freq") of the band parameters, built at compile time. */
+struct BandParameterText {
+    char id[16]{};
+    char name[16]{};
+};
+
+constexpr void appendText(char *destination, int &length, const char *text) {
+    while (*text != 0)
+        destination[length++] = *text++;
+}
+
+constexpr void appendNumber(char *destination, int &length, int number) {
+    if (number >= 10)
+        destination[length++] = (char) ('0' + number / 10);
+
+    destination[length++] = (char) ('0' + number % 10);
+}
+
+constexpr std::array<BandParameterText, numBands * (size_t) BandParam::numBandParams> makeBandParameterText() {
+    constexpr const char *idSuffixes[] = {"Active", "Type", "Freq", "Gain", "Q"};
+    constexpr const char *nameSuffixes[] = {" Active", " Type", " Freq", " Gain", " Q"};
+
+    std::array<BandParameterText, numBands * (size_t) BandParam::numBandParams> result{};
+
+    for (int band = 0; band < numBands; ++band) {
+        for (int field = 0; field < (int) BandParam::numBandParams; ++field) {
+            auto &text = result[(size_t) (band * (int) BandParam::numBandParams + field)];
+            int idLength = 0, nameLength = 0;
+
+            appendText(text.id, idLength, "band");
+            appendNumber(text.id, idLength, band + 1);
+            appendText(text.id, idLength, idSuffixes[field]);
+
+            appendText(text.name, nameLength, "Band ");
+            appendNumber(text.name, nameLength, band + 1);
+            appendText(text.name, nameLength, nameSuffixes[field]);
+        }
+    }
+
+    return result;
+}
+
+inline constexpr auto bandParameterText = makeBandParameterText();
+
+// spread over the spectrum, 0.6 octaves apart
+inline constexpr float bandDefaultFrequencies[numBands] = {
+    30.0f, 45.0f, 70.0f, 105.0f, 160.0f, 240.0f, 365.0f, 550.0f,
+    835.0f, 1270.0f, 1920.0f, 2910.0f, 4410.0f, 6680.0f, 10130.0f, 15360.0f
+};
+
+constexpr std::array<ParameterDescriptor, (size_t) Param::numParameters> makeParameterDescriptors() {
+    std::array<ParameterDescriptor, (size_t) Param::numParameters> result{};
+
+    for (size_t i = 0; i < fixedParameterDescriptors.size(); ++i)
+        result[i] = fixedParameterDescriptors[i];
+
+    for (int band = 0; band < numBands; ++band) {
+        auto text = [band](BandParam field) -> const BandParameterText & {
+            return bandParameterText[(size_t) (band * (int) BandParam::numBandParams + (int) field)];
+        };
+        auto add = [&result, band](BandParam field, const ParameterDescriptor &descriptor) {
+            result[(size_t) getBandParam(band, field)] = descriptor;
+        };
+
+        add(BandParam::active, makeBool(getBandParam(band, BandParam::active), text(BandParam::active).id,
+                                        text(BandParam::active).name, false));
+        add(BandParam::type, makeChoice(getBandParam(band, BandParam::type), text(BandParam::type).id,
+                                        text(BandParam::type).name, bandTypeChoices, 0));
+        add(BandParam::freq, makeFloat(getBandParam(band, BandParam::freq), text(BandParam::freq).id,
+                                       text(BandParam::freq).name, 20.0f, 20000.0f, bandDefaultFrequencies[band],
+                                       1.0f, 0.25f));
+        add(BandParam::gain, makeFloat(getBandParam(band, BandParam::gain), text(BandParam::gain).id,
+                                       text(BandParam::gain).name, -24.0f, 24.0f, 0.0f));
+        add(BandParam::quality, makeFloat(getBandParam(band, BandParam::quality), text(BandParam::quality).id,
+                                          text(BandParam::quality).name, 0.1f, 10.0f, 1.0f));
+    }
+
+    return result;
+}
+
+inline constexpr auto parameterDescriptors = makeParameterDescriptors();
+
+constexpr bool descriptorsMatchParamOrder() {
+    for (size_t i = 0; i < parameterDescriptors.size(); ++i)
+        if ((size_t) parameterDescriptors[i].param != i)
+            return false;
+
+    return true;
+}
+
+static_assert(descriptorsMatchParamOrder(), "parameterDescriptors must be listed in Param order");
+
+constexpr const ParameterDescriptor &getDescriptor(Param param) {
+    return parameterDescriptors[(size_t) param];
+}
+
+constexpr const char *getParameterId(Param param) {
+    return getDescriptor(param).id;
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+/**
+ The raw value of every parameter, looked up once. The audio thread reads
+ parameters by index through these instead of by name.
+ */
+class ParameterHandles {
+public:
+    explicit ParameterHandles(juce::AudioProcessorValueTreeState &apvts);
+
+    float get(Param param) const { return values[(size_t) param]->load(); }
+
+    bool getBool(Param param) const { return get(param) > 0.5f; }
+
+    int getChoice(Param param) const { return juce::roundToInt(get(param)); }
+
+private:
+    std::array<std::atomic<float> *, (size_t) Param::numParameters> values;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SvfCascade.h"
+
+/**
+ Level detector and gain computer for the dynamic peak band.
+
+ The detector listens to the band itself: the mean of the detected channels
+ goes through a band pass at the peak's frequency and Q, then a peak
+ envelope follower with separate attack and release. Whatever the band
+ rises above the threshold is pulled down by the ratio, and the result is
+ read at control rate as a gain offset for the peak.
+ */
+class PeakDynamics {
+public:
+    /** The deepest cut the dynamics apply, the range of the peak gain. */
+    static constexpr float maxReductionDecibels = 24.0f;
+
+    void prepare(double newSampleRate, int maximumBlockSize) {
+        sampleRate = newSampleRate;
+        envelopeBuffer.assign((size_t) maximumBlockSize, 0.0f);
+        bandPass.prepare({sampleRate, (juce::uint32) maximumBlockSize, 1});
+        bandPass.setNumActiveStages(1);
+        reset();
+    }
+
+    void reset() {
+        bandPass.reset();
+        envelope = 0.0f;
+        std::fill(envelopeBuffer.begin(), envelopeBuffer.end(), 0.0f);
+    }
+
+    template<typename Math = PreciseMath>
+    void setBand(double frequency, double Q) {
+        bandPass.setSection(0, makeSvfBandPass<Math>(sampleRate, frequency, Q));
+    }
+
+    void setDynamics(float newThresholdDecibels, float newRatio, float attackMs, float releaseMs) {
+        thresholdDecibels = newThresholdDecibels;
+        slope = 1.0f - 1.0f / newRatio;
+        attackCoefficient = (float) std::exp(-1000.0 / (attackMs * sampleRate));
+        releaseCoefficient = (float) std::exp(-1000.0 / (releaseMs * sampleRate));
+    }
+
+    /** Runs the detector over the first numChannels channels of a block. */
+    template<typename SampleType>
+    void analyse(const juce::AudioBuffer<SampleType> &buffer, int numChannels, int numSamples) noexcept {
+        jassert(numSamples <= (int) envelopeBuffer.size());
+        numAnalysedSamples = numSamples;
+
+        if (numChannels == 0) {
+            std::fill(envelopeBuffer.begin(), envelopeBuffer.begin() + numSamples, 0.0f);
+            return;
+        }
+
+        const auto scale = 1.0f / (float) numChannels;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const auto *input = buffer.getReadPointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                envelopeBuffer[(size_t) i] = (channel == 0 ? 0.0f : envelopeBuffer[(size_t) i]) + (float) input[i] * scale;
+        }
+
+        auto *data = envelopeBuffer.data();
+        juce::dsp::AudioBlock<float> block(&data, 1, (size_t) numSamples);
+        bandPass.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+        for (int i = 0; i < numSamples; ++i) {
+            const auto level = std::abs(envelopeBuffer[(size_t) i]);
+            const auto coefficient = level > envelope ? attackCoefficient : releaseCoefficient;
+            envelope = level + coefficient * (envelope - level);
+            envelopeBuffer[(size_t) i] = envelope;
+        }
+    }
+
+    /** The gain offset (0 dB or less) for a sample of the last analysed block. */
+    float getGainDecibels(int sampleIndex) const noexcept {
+        jassert(sampleIndex < numAnalysedSamples);
+
+        const auto level = juce::Decibels::gainToDecibels(envelopeBuffer[(size_t) sampleIndex]);
+        const auto over = level - thresholdDecibels;
+
+        return over > 0.0f ? juce::jmax(-maxReductionDecibels, -over * slope) : 0.0f;
+    }
+
+private:
+    double sampleRate = 44100.0;
+
+    SvfCascade<float, 1> bandPass;
+    std::vector<float> envelopeBuffer;
+    int numAnalysedSamples = 0;
+    float envelope = 0.0f;
+
+    float thresholdDecibels = 0.0f, slope = 0.0f;
+    float attackCoefficient = 0.0f, releaseCoefficient = 0.0f;
+};
@@ -9,97 +9,126 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-ResponseCurveComponent::ResponseCurveComponent(BassQualizerAudioProcessor& p) : audioProcessor(p), leftChannelFifo(&p.leftChannelFifo)
+bool PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate, juce::Path& path)
 {
-    const auto& params = audioProcessor.getParameters();
-    for (auto param : params)
-    {
-        param->addListener(this);
-    }
+    // everything that arrived since the last pass, read straight from the
+    // ring; only the newest FFT would be drawn, so one is enough
+    const auto readable = leftChannelRing->getReadable();
 
-    leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
-    monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+    if (readable.size() == 0)
+        return false;
 
-    startTimerHz(60);
+    appendToMonoBuffer(readable.first.data, readable.first.size);
+    appendToMonoBuffer(readable.second.data, readable.second.size);
+    leftChannelRing->release(readable.size());
+
+    leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+
+    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
+    const auto binWidth = sampleRate / (double)fftSize;
+
+    pathProducer.generatePath(leftChannelFFTDataGenerator.getFFTData(), fftBounds, fftSize, (float)binWidth, -48.f, path);
+    return true;
 }
 
-ResponseCurveComponent::~ResponseCurveComponent()
+void PathProducer::appendToMonoBuffer(const float* samples, int numSamples)
 {
-    const auto& params = audioProcessor.getParameters();
-    for (auto param : params)
+    const auto size = monoBuffer.getNumSamples();
+
+    if (numSamples <= 0)
+        return;
+
+    // only the newest samples fit
+    if (numSamples >= size)
     {
-        param->removeListener(this);
+        juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0), samples + numSamples - size, size);
+        return;
     }
-}
 
+    // the ranges overlap, which std::copy allows when moving towards the front
+    auto* data = monoBuffer.getWritePointer(0);
+    std::copy(data + numSamples, data + size, data);
 
-void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
+    juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, size - numSamples), samples, numSamples);
+}
+
+AnalyzerThread::AnalyzerThread(BassQualizerAudioProcessor& p)
+    : juce::Thread("BassQualizer Analyzer"), audioProcessor(p), pathProducer(p.leftChannelRing)
 {
-    parametersChanged.set(true);
 }
 
-void ResponseCurveComponent::timerCallback()
+AnalyzerThread::~AnalyzerThread()
 {
+    stopThread(1000);
+}
 
-    juce::AudioBuffer<float> tempIncomingBuffer;
+void AnalyzerThread::setPathBounds(juce::Rectangle<float> bounds)
+{
+    const juce::SpinLock::ScopedLockType lock(boundsLock);
+    pathBounds = bounds;
+}
 
-    while( leftChannelFifo->getNumCompleteBuffersAvailable() > 0 )
+void AnalyzerThread::run()
+{
+    while (!threadShouldExit())
     {
-        if( leftChannelFifo->getAudioBuffer(tempIncomingBuffer) )
+        juce::Rectangle<float> bounds;
         {
-            auto size = tempIncomingBuffer.getNumSamples();
+            const juce::SpinLock::ScopedLockType lock(boundsLock);
+            bounds = pathBounds;
+        }
 
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
-                                              monoBuffer.getReadPointer(0, size),
-                                              monoBuffer.getNumSamples() - size);
+        // the path in the write buffer is only replaced, so a pass that
+        // finds nothing new publishes nothing
+        if (!bounds.isEmpty() && pathProducer.process(bounds, audioProcessor.getSampleRate(), paths.getWriteBuffer()))
+            paths.publish();
 
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                                              tempIncomingBuffer.getReadPointer(0, 0),
-                                              size);
+        wait(intervalMs);
+    }
+}
 
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
-        }
+ResponseCurveComponent::ResponseCurveComponent(BassQualizerAudioProcessor& p) : audioProcessor(p), analyzerThread(p)
+{
+    const auto& params = audioProcessor.getParameters();
+    for (auto param : params)
+    {
+        param->addListener(this);
     }
 
-    const auto fftBounds = getAnalysisArea().toFloat();
-    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
+    analyzerThread.startThread();
 
-    const auto binWidth = audioProcessor.getSampleRate() / (double)fftSize;
+    startTimerHz(60);
+}
 
-    while( leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0 )
+ResponseCurveComponent::~ResponseCurveComponent()
+{
+    const auto& params = audioProcessor.getParameters();
+    for (auto param : params)
     {
-        std::vector<float> fftData;
-        if( leftChannelFFTDataGenerator.getFFTData(fftData) )
-        {
-            pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
-        }
+        param->removeListener(this);
     }
+}
 
-    while (pathProducer.getNumPathsAvailable())
-    {
-        pathProducer.getPath(leftChannelFFTPath);
-    }
 
+void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
+{
+    parametersChanged.set(true);
+}
 
+void ResponseCurveComponent::timerCallback()
+{
+    // the analyzer thread does the FFT; this only picks up its newest path
+    analyzerThread.setPathBounds(getAnalysisArea().toFloat());
+    analyzerThread.fetchPath();
 
     if(parametersChanged.compareAndSetBool(false, true))
     {
         DBG("Params changed");
         // update the mono chain
-        auto chainSettings = getChainSettings(audioProcessor.apvts);
-
-        monoChain.setBypassed<ChainPositions::lowCut>(chainSettings.lowCutBypassed);
-        monoChain.setBypassed<ChainPositions::peak>(chainSettings.peakBypassed);
-        monoChain.setBypassed<ChainPositions::highCut>(chainSettings.highCutBypassed);
-
-        auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-        updateCoefficients(monoChain.get<ChainPositions::peak>().coefficients, peakCoefficients);
-
-        auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-        auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
-
-        updateCutFilter(monoChain.get<ChainPositions::lowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-        updateCutFilter(monoChain.get<ChainPositions::highCut>(), highCutCoefficients, chainSettings.highCutSlope);
+        auto chainSettings = getChainSettings(audioProcessor.getParameterHandles());
+        updateMonoChain(monoChain, chainSettings, audioProcessor.getSampleRate());
+        updateMonoChain(secondMonoChain, getSecondSide(chainSettings), audioProcessor.getSampleRate());
+        showSecondSide = chainSettings.stereoMode != StereoMode::Linked;
         // signal a repaint
         //repaint();
 
@@ -121,78 +150,56 @@ void ResponseCurveComponent::paint (juce::Graphics& g)
 
     auto w = responseArea.getWidth();
 
-    auto& lowcut = monoChain.get<ChainPositions::lowCut>();
-    auto& peak = monoChain.get<ChainPositions::peak>();
-    auto& highcut = monoChain.get<ChainPositions::highCut>();
-
     auto sampleRate = audioProcessor.getSampleRate();
 
-    std::vector<double> mags;
-
-    mags.resize(w);
-
-    for( int i = 0; i < w; ++i){
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-
-        if(! monoChain.isBypassed<ChainPositions::peak>())
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-
-        if(! monoChain.isBypassed<ChainPositions::lowCut>()) {
-            if(!lowcut.isBypassed<0>())
-                mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+    const double outputMin = responseArea.getBottom();
+    const double outputMax = responseArea.getY();
+    auto map = [outputMin, outputMax](double input)
+    {
+        return jmap(input, -24.0, 24.0, outputMin, outputMax);
+    };
 
-            if(!lowcut.isBypassed<1>())
-                mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+    auto makeResponseCurve = [&](const MonoChain& chain)
+    {
+        std::vector<double> mags;
 
-            if(!lowcut.isBypassed<2>())
-                mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+        mags.resize(w);
 
-            if(!lowcut.isBypassed<3>())
-                mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+        for( int i = 0; i < w; ++i){
+            auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+            auto mag = getMagnitudeForFrequency(chain, freq, sampleRate);
 
+            mags[i] = Decibels::gainToDecibels(mag);
         }
-        if (!monoChain.isBypassed<ChainPositions::highCut>())
-        {
-            if(!highcut.isBypassed<0>())
-                mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
 
-            if(!highcut.isBypassed<1>())
-                mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+        Path curve;
 
-            if(!highcut.isBypassed<2>())
-                mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+        curve.startNewSubPath(responseArea.getX(), map(mags.front()));
 
-            if(!highcut.isBypassed<3>())
-                mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+        for (size_t i = 1; i < mags.size(); ++i){
+            curve.lineTo(responseArea.getX() + i, map(mags[i]));
         }
 
-        mags[i] = Decibels::gainToDecibels(mag);
-    }
-    
-    Path responseCurve;
-
-    const double outputMin = responseArea.getBottom();
-    const double outputMax = responseArea.getY();
-    auto map = [outputMin, outputMax](double input)
-    {
-        return jmap(input, -24.0, 24.0, outputMin, outputMax);
+        return curve;
     };
 
-    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
-
-    for (size_t i = 1; i < mags.size(); ++i){
-        responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
-    }
+    auto responseCurve = makeResponseCurve(monoChain);
 
 
-    leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
     g.setColour(Colours::blue);
-    g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
+    g.strokePath(analyzerThread.getPath(), PathStrokeType(1.f),
+                 AffineTransform::translation((float)responseArea.getX(), (float)responseArea.getY()));
 
     g.setColour(Colours::orange);
     g.drawRoundedRectangle(responseArea.toFloat(), 4.f, 1.f);
 
+    // the right or side channel, when it has its own settings
+    if (showSecondSide)
+    {
+        g.setColour(Colours::lightgreen);
+        g.strokePath(makeResponseCurve(secondMonoChain), PathStrokeType(2.f));
+    }
+
     g.setColour(Colours::white);
     g.strokePath(responseCurve, PathStrokeType(2.f));
 
@@ -220,27 +227,109 @@ juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea()
     return bounds;
 }
 
+LevelMeterComponent::LevelMeterComponent(BassQualizerAudioProcessor& p)
+    : displays{{{&p.inputMeter, "IN"}, {&p.outputMeter, "OUT"}}}
+{
+    startTimerHz(30);
+}
+
+void LevelMeterComponent::timerCallback()
+{
+    // the peak lines fall by about 26 dB per second
+    constexpr auto decay = 0.9f;
+
+    for (auto& display : displays)
+    {
+        const auto readings = display.meter->read();
+        display.peak = juce::jmax(readings.peak, display.peak * decay);
+        display.truePeakHold = juce::jmax(readings.truePeak, display.truePeakHold);
+        display.rms = readings.rms;
+        display.overs = readings.overs;
+    }
+
+    repaint();
+}
+
+void LevelMeterComponent::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    g.fillAll(Colours::black);
+
+    constexpr auto minDecibels = -60.0f, maxDecibels = 6.0f;
+    auto columns = getLocalBounds().reduced(4, 12);
+    const auto columnWidth = columns.getWidth() / (int) displays.size();
+
+    for (const auto& display : displays)
+    {
+        auto column = columns.removeFromLeft(columnWidth).reduced(3, 0);
+
+        g.setColour(Colours::white);
+        g.setFont(11.f);
+        g.drawFittedText(display.name, column.removeFromTop(14), Justification::centred, 1);
+
+        const auto oversArea = column.removeFromBottom(14);
+        const auto truePeakArea = column.removeFromBottom(14);
+        const auto truePeak = Decibels::gainToDecibels(display.truePeakHold, minDecibels);
+        g.setColour(truePeak >= 0.0f ? Colours::red : Colours::white);
+        g.drawFittedText(display.truePeakHold > 0.0f ? String(truePeak, 1) : "-inf", truePeakArea,
+                         Justification::centred, 1);
+        g.setColour(display.overs > 0 ? Colours::red : Colours::grey);
+        g.drawFittedText(String(display.overs), oversArea, Justification::centred, 1);
+
+        const auto bar = column.reduced(0, 2).toFloat();
+        auto toY = [&](float gain)
+        {
+            const auto decibels = jlimit(minDecibels, maxDecibels, Decibels::gainToDecibels(gain, minDecibels));
+            return jmap(decibels, minDecibels, maxDecibels, bar.getBottom(), bar.getY());
+        };
+
+        g.setColour(Colours::darkgrey);
+        g.fillRect(bar);
+
+        g.setColour(Colours::green);
+        g.fillRect(bar.withTop(toY(display.rms)));
+
+        g.setColour(Colours::white);
+        g.fillRect(bar.getX(), toY(display.peak), bar.getWidth(), 2.f);
+
+        g.setColour(Colours::orange);
+        g.drawHorizontalLine(roundToInt(toY(1.0f)), bar.getX(), bar.getRight());
+    }
+}
+
+void LevelMeterComponent::mouseDown(const juce::MouseEvent&)
+{
+    for (auto& display : displays)
+    {
+        display.meter->resetOvers();
+        display.truePeakHold = 0.0f;
+        display.overs = 0;
+    }
+
+    repaint();
+}
+
+//==============================================================================
+static std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> attachChoices(
+    juce::AudioProcessorValueTreeState &apvts, Param param, juce::ComboBox &box)
+{
+    const auto &descriptor = getDescriptor(param);
+    jassert(descriptor.type == ParameterType::Choice);
+
+    for (int i = 0; i < descriptor.numChoices; ++i)
+        box.addItem(descriptor.choices[i], i + 1);
+
+    box.setTooltip(descriptor.name);
+
+    return std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        apvts, descriptor.id, box);
+}
 
 //==============================================================================
 BassQualizerAudioProcessorEditor::BassQualizerAudioProcessorEditor (BassQualizerAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p),
     responseCurveComponent(audioProcessor),
-    peakFreqSliderAttachment(audioProcessor.apvts, "peakFreq", peakFreqSlider),
-    peakGainSliderAttachment(audioProcessor.apvts, "peakGainInDb", peakGainSlider),
-    peakqualitySliderAttachment(audioProcessor.apvts, "peakQuality", peakqualitySlider),
-    lowcutFreqSliderAttachment(audioProcessor.apvts, "lowCutFreq", lowcutFreqSlider),
-    highcutFreqSliderAttachment(audioProcessor.apvts, "highCutFreq", highcutFreqSlider),
-    lowcutSlopeSliderAttachment(audioProcessor.apvts, "lowCutSlope", lowcutSlopeSlider),
-    highcutSlopeSliderAttachment(audioProcessor.apvts, "highCutSlope", highcutSlopeSlider),
-    lowcutBypassButtonAttachment(audioProcessor.apvts, "lowCutBypass", lowcutBypassButton),
-    peakBypassButtonAttachment(audioProcessor.apvts, "peakBypass", peakBypassButton),
-    highcutBypassButtonAttachment(audioProcessor.apvts, "highCutBypass", highcutBypassButton),
-    reverbRoomSizeAttachment(audioProcessor.apvts, "reverbRoomSize", reverbRoomSizeSlider),
-    reverbDampingAttachment(audioProcessor.apvts, "reverbDamping", reverbDampingSlider),
-    reverbWidthAttachment(audioProcessor.apvts, "reverbWidth", reverbWidthSlider),
-    reverbDryLevelAttachment(audioProcessor.apvts, "reverbDryLevel", reverbDryLevelSlider),
-    reverbWetLevelAttachment(audioProcessor.apvts, "reverbWetLevel", reverbWetLevelSlider),
-    reverbBypassButtonAttachment(audioProcessor.apvts, "reverbBypass", reverbBypassButton)
+    levelMeterComponent(audioProcessor)
 
 {
     peakFreqSlider.setLookAndFeel(&lookAndFeelV1);
@@ -273,11 +362,57 @@ BassQualizerAudioProcessorEditor::BassQualizerAudioProcessorEditor (BassQualizer
     addAndMakeVisible(peakLabel);
     addAndMakeVisible(reverbLabel);
 
+    attachControls();
+
+    loadImpulseResponseButton.onClick = [this] { chooseImpulseResponse(); };
+    loadImpulseResponseButton.setTooltip(audioProcessor.getImpulseResponseFile().getFileName());
+
+    lfoRateSlider.setTextValueSuffix(" Hz");
+    lfoDepthSlider.setTextValueSuffix(" oct");
+    peakThresholdSlider.setTextValueSuffix(" dB");
+    peakRatioSlider.setTextValueSuffix(":1");
+    peakAttackSlider.setTextValueSuffix(" ms");
+    peakReleaseSlider.setTextValueSuffix(" ms");
+    monoBassFreqSlider.setTextValueSuffix(" Hz");
+    bandFreqSlider.setTextValueSuffix(" Hz");
+    bandGainSlider.setTextValueSuffix(" dB");
+    lowCutFreq2Slider.setTextValueSuffix(" Hz");
+    peakFreq2Slider.setTextValueSuffix(" Hz");
+    peakGain2Slider.setTextValueSuffix(" dB");
+    highCutFreq2Slider.setTextValueSuffix(" Hz");
+
+    for (int band = 0; band < numBands; ++band)
+        bandSelectorBox.addItem("Band " + juce::String(band + 1), band + 1);
+
+    bandSelectorBox.onChange = [this] { selectBand(bandSelectorBox.getSelectedItemIndex()); };
+    bandSelectorBox.setSelectedItemIndex(0, juce::dontSendNotification);
+    selectBand(0);
+
     for( auto* comp : getComps()){
         addAndMakeVisible(comp);
     }
 
-    setSize (1200, 800);
+    for( auto* comp : getOptionComps()){
+        addAndMakeVisible(comp);
+    }
+
+    for( auto* comp : getDynamicsComps()){
+        addAndMakeVisible(comp);
+    }
+
+    for( auto* comp : getBandComps()){
+        addAndMakeVisible(comp);
+    }
+
+    for( auto* comp : getSecondSideComps()){
+        addAndMakeVisible(comp);
+    }
+
+    addAndMakeVisible(reverbEngineBox);
+    addAndMakeVisible(loadImpulseResponseButton);
+    addAndMakeVisible(fdnHalfRateButton);
+
+    setSize (1200, 872);
 }
 
 BassQualizerAudioProcessorEditor::~BassQualizerAudioProcessorEditor()
@@ -313,6 +448,7 @@ void BassQualizerAudioProcessorEditor::resized()
     auto bounds = getLocalBounds();
     auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
 
+    levelMeterComponent.setBounds(responseArea.removeFromRight(90));
     responseCurveComponent.setBounds(responseArea);
 
     auto topArea = bounds.removeFromTop(bounds.getHeight() * 0.5);
@@ -341,11 +477,43 @@ void BassQualizerAudioProcessorEditor::resized()
     peakqualitySlider.setBounds(peakArea);
 
     auto bottomArea = bounds;
-    bottomArea.removeFromTop(50);
+    auto optionsArea = bottomArea.removeFromTop(50).reduced(20, 12);
+
+    const auto optionComps = getOptionComps();
+    const auto optionWidth = juce::jmin(200, optionsArea.getWidth() / (int) optionComps.size());
+
+    for( auto* comp : optionComps){
+        comp->setBounds(optionsArea.removeFromLeft(optionWidth).reduced(5, 0));
+    }
+
+    auto dynamicsArea = bottomArea.removeFromTop(36).reduced(20, 6);
+
+    for( auto* comp : getDynamicsComps()){
+        comp->setBounds(dynamicsArea.removeFromLeft(optionWidth).reduced(5, 0));
+    }
+
+    auto bandArea = bottomArea.removeFromTop(36).reduced(20, 6);
+
+    for( auto* comp : getBandComps()){
+        comp->setBounds(bandArea.removeFromLeft(optionWidth).reduced(5, 0));
+    }
+
+    auto secondSideArea = bottomArea.removeFromTop(36).reduced(20, 6);
+
+    const auto secondSideComps = getSecondSideComps();
+    const auto secondSideWidth = secondSideArea.getWidth() / (int) secondSideComps.size();
+
+    for( auto* comp : secondSideComps){
+        comp->setBounds(secondSideArea.removeFromLeft(secondSideWidth).reduced(3, 0));
+    }
 
     reverbLabel.setBounds(bottomArea.removeFromTop(25));
     reverbLabel.setJustificationType(juce::Justification::centred);
-    reverbBypassButton.setBounds(bottomArea.removeFromTop(25));
+    auto reverbHeaderArea = bottomArea.removeFromTop(25);
+    loadImpulseResponseButton.setBounds(reverbHeaderArea.removeFromRight(150).reduced(5, 0));
+    fdnHalfRateButton.setBounds(reverbHeaderArea.removeFromRight(150).reduced(5, 0));
+    reverbEngineBox.setBounds(reverbHeaderArea.removeFromRight(150).reduced(5, 0));
+    reverbBypassButton.setBounds(reverbHeaderArea);
 
     auto borderSpacing = 100;
     bottomArea.reduce(borderSpacing, 0);
@@ -390,6 +558,7 @@ std::vector<juce::Component*> BassQualizerAudioProcessorEditor::getComps()
         &reverbWidthSlider,
 
         &responseCurveComponent,
+        &levelMeterComponent,
 
         &lowcutBypassButton,
         &peakBypassButton,
@@ -398,3 +567,180 @@ std::vector<juce::Component*> BassQualizerAudioProcessorEditor::getComps()
     };
 }
 
+void BassQualizerAudioProcessorEditor::chooseImpulseResponse()
+{
+    impulseResponseChooser = std::make_unique<juce::FileChooser>("Load an impulse response",
+                                                                 audioProcessor.getImpulseResponseFile(),
+                                                                 "*.wav;*.aif;*.aiff;*.flac");
+
+    const auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+
+    impulseResponseChooser->launchAsync(flags, [this](const juce::FileChooser &chooser) {
+        const auto file = chooser.getResult();
+
+        if (file.existsAsFile()) {
+            audioProcessor.loadImpulseResponse(file);
+            loadImpulseResponseButton.setTooltip(file.getFileName());
+        }
+    });
+}
+
+std::vector<juce::Component*> BassQualizerAudioProcessorEditor::getDynamicsComps()
+{
+    return
+    {
+        &peakDynamicButton,
+        &peakThresholdSlider,
+        &peakRatioSlider,
+        &peakAttackSlider,
+        &peakReleaseSlider,
+        &peakSidechainButton,
+        &monoBassButton,
+        &monoBassFreqSlider
+    };
+}
+
+std::vector<juce::Component*> BassQualizerAudioProcessorEditor::getOptionComps()
+{
+    return
+    {
+        &filterTopologyBox,
+        &phaseModeBox,
+        &designMethodBox,
+        &lfoTargetBox,
+        &lfoShapeBox,
+        &lfoRateSlider,
+        &lfoDepthSlider,
+        &lfoAudioRateButton,
+        &multirateBassButton
+    };
+}
+
+void BassQualizerAudioProcessorEditor::attachControls()
+{
+    // the band row isn't listed; selectBand() attaches it to one band at a time
+    const std::pair<Param, juce::Component*> controls[] = {
+        {Param::peakFreq, &peakFreqSlider},
+        {Param::peakGainInDb, &peakGainSlider},
+        {Param::peakQuality, &peakqualitySlider},
+        {Param::lowCutFreq, &lowcutFreqSlider},
+        {Param::highCutFreq, &highcutFreqSlider},
+        {Param::lowCutSlope, &lowcutSlopeSlider},
+        {Param::highCutSlope, &highcutSlopeSlider},
+        {Param::lowCutBypass, &lowcutBypassButton},
+        {Param::peakBypass, &peakBypassButton},
+        {Param::highCutBypass, &highcutBypassButton},
+        {Param::reverbRoomSize, &reverbRoomSizeSlider},
+        {Param::reverbDamping, &reverbDampingSlider},
+        {Param::reverbWidth, &reverbWidthSlider},
+        {Param::reverbDryLevel, &reverbDryLevelSlider},
+        {Param::reverbWetLevel, &reverbWetLevelSlider},
+        {Param::reverbBypass, &reverbBypassButton},
+        {Param::filterTopology, &filterTopologyBox},
+        {Param::phaseMode, &phaseModeBox},
+        {Param::designMethod, &designMethodBox},
+        {Param::lfoShape, &lfoShapeBox},
+        {Param::lfoTarget, &lfoTargetBox},
+        {Param::lfoRate, &lfoRateSlider},
+        {Param::lfoDepth, &lfoDepthSlider},
+        {Param::lfoAudioRate, &lfoAudioRateButton},
+        {Param::multirateBass, &multirateBassButton},
+        {Param::peakDynamic, &peakDynamicButton},
+        {Param::peakSidechain, &peakSidechainButton},
+        {Param::peakThreshold, &peakThresholdSlider},
+        {Param::peakRatio, &peakRatioSlider},
+        {Param::peakAttack, &peakAttackSlider},
+        {Param::peakRelease, &peakReleaseSlider},
+        {Param::monoBass, &monoBassButton},
+        {Param::monoBassFreq, &monoBassFreqSlider},
+        {Param::autoGain, &autoGainButton},
+        {Param::autoGainFreeze, &autoGainFreezeButton},
+        {Param::stereoMode, &stereoModeBox},
+        {Param::lowCutSlope2, &lowCutSlope2Box},
+        {Param::highCutSlope2, &highCutSlope2Box},
+        {Param::lowCutBypass2, &lowCutBypass2Button},
+        {Param::peakBypass2, &peakBypass2Button},
+        {Param::highCutBypass2, &highCutBypass2Button},
+        {Param::lowCutFreq2, &lowCutFreq2Slider},
+        {Param::peakFreq2, &peakFreq2Slider},
+        {Param::peakGainInDb2, &peakGain2Slider},
+        {Param::peakQuality2, &peakQuality2Slider},
+        {Param::highCutFreq2, &highCutFreq2Slider},
+        {Param::reverbEngine, &reverbEngineBox},
+        {Param::fdnHalfRate, &fdnHalfRateButton},
+    };
+
+    auto &apvts = audioProcessor.apvts;
+
+    for (const auto& [param, control] : controls)
+    {
+        if (auto* slider = dynamic_cast<juce::Slider*>(control))
+            sliderAttachments.push_back(std::make_unique<Attachment>(apvts, getParameterId(param), *slider));
+        else if (auto* button = dynamic_cast<juce::Button*>(control))
+            buttonAttachments.push_back(std::make_unique<ButtonAttachment>(apvts, getParameterId(param), *button));
+        else if (auto* box = dynamic_cast<juce::ComboBox*>(control))
+            comboBoxAttachments.push_back(attachChoices(apvts, param, *box));
+        else
+            jassertfalse;
+    }
+}
+
+void BassQualizerAudioProcessorEditor::selectBand(int band)
+{
+    if (!juce::isPositiveAndBelow(band, numBands))
+        return;
+
+    // the old attachments go first, so they can't write the new band's
+    // values back to the old band
+    bandTypeAttachment.reset();
+    bandActiveAttachment.reset();
+    bandFreqAttachment.reset();
+    bandGainAttachment.reset();
+    bandQualityAttachment.reset();
+
+    auto &apvts = audioProcessor.apvts;
+
+    bandTypeBox.clear(juce::dontSendNotification);
+    bandTypeAttachment = attachChoices(apvts, getBandParam(band, BandParam::type), bandTypeBox);
+    bandActiveAttachment = std::make_unique<ButtonAttachment>(
+        apvts, getParameterId(getBandParam(band, BandParam::active)), bandActiveButton);
+    bandFreqAttachment = std::make_unique<Attachment>(
+        apvts, getParameterId(getBandParam(band, BandParam::freq)), bandFreqSlider);
+    bandGainAttachment = std::make_unique<Attachment>(
+        apvts, getParameterId(getBandParam(band, BandParam::gain)), bandGainSlider);
+    bandQualityAttachment = std::make_unique<Attachment>(
+        apvts, getParameterId(getBandParam(band, BandParam::quality)), bandQualitySlider);
+}
+
+std::vector<juce::Component*> BassQualizerAudioProcessorEditor::getBandComps()
+{
+    return
+    {
+        &bandSelectorBox,
+        &bandActiveButton,
+        &bandTypeBox,
+        &bandFreqSlider,
+        &bandGainSlider,
+        &bandQualitySlider,
+        &autoGainButton,
+        &autoGainFreezeButton
+    };
+}
+
+std::vector<juce::Component*> BassQualizerAudioProcessorEditor::getSecondSideComps()
+{
+    return
+    {
+        &stereoModeBox,
+        &lowCutBypass2Button,
+        &lowCutFreq2Slider,
+        &lowCutSlope2Box,
+        &peakBypass2Button,
+        &peakFreq2Slider,
+        &peakGain2Slider,
+        &peakQuality2Slider,
+        &highCutBypass2Button,
+        &highCutFreq2Slider,
+        &highCutSlope2Box
+    };
+}
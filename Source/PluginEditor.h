@@ -11,6 +11,7 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "myLookAndFeel.h"
+#include "TripleBuffer.h"
 
 enum FFTOrder {
     order2048 = 11,
@@ -54,8 +55,6 @@ struct FFTDataGenerator {
         for (int i = 0; i < numBins; ++i) {
             fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
         }
-
-        fftDataFifo.push(fftData);
     }
 
     void changeOrder(FFTOrder newOrder) {
@@ -72,42 +71,39 @@ struct FFTDataGenerator {
 
         fftData.clear();
         fftData.resize(fftSize * 2, 0);
-
-        fftDataFifo.prepare(fftData.size());
     }
 
     //==============================================================================
     int getFFTSize() const { return 1 << order; }
-    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
     //==============================================================================
-    bool getFFTData(BlockType &fftData) { return fftDataFifo.pull(fftData); }
+    /** The spectrum in decibels, as of the last produceFFTDataForRendering. */
+    const BlockType &getFFTData() const { return fftData; }
 
 private:
     FFTOrder order;
     BlockType fftData;
     std::unique_ptr<juce::dsp::FFT> forwardFFT;
     std::unique_ptr<juce::dsp::WindowingFunction<float> > window;
-
-    Fifo<BlockType> fftDataFifo;
 };
 
 template<typename PathType>
 struct AnalyzerPathGenerator {
     /*
-     converts 'renderData[]' into a juce::Path
+     converts 'renderData[]' into a juce::Path, reusing p's storage
      */
     void generatePath(const std::vector<float> &renderData,
                       juce::Rectangle<float> fftBounds,
                       int fftSize,
                       float binWidth,
-                      float negativeInfinity) {
+                      float negativeInfinity,
+                      PathType &p) {
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
         auto width = fftBounds.getWidth();
 
         int numBins = (int) fftSize / 2;
 
-        PathType p;
+        p.clear();
         p.preallocateSpace(3 * (int) fftBounds.getWidth());
 
         auto map = [bottom, top, negativeInfinity](float v) {
@@ -138,20 +134,7 @@ struct AnalyzerPathGenerator {
                 p.lineTo(binX, y);
             }
         }
-
-        pathFifo.push(p);
     }
-
-    int getNumPathsAvailable() const {
-        return pathFifo.getNumAvailableForReading();
-    }
-
-    bool getPath(PathType &path) {
-        return pathFifo.pull(path);
-    }
-
-private:
-    Fifo<PathType> pathFifo;
 };
 
 struct LookAndFeel : juce::LookAndFeel_V4 {
@@ -204,25 +187,61 @@ private:
 };
 
 struct PathProducer {
-    PathProducer(SingleChannelSampleFifo<BassQualizerAudioProcessor::BlockType> &scsf) : leftChannelFifo(&scsf) {
+    PathProducer(SampleRing &ring) : leftChannelRing(&ring) {
         leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
         monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
     }
 
-    void process(juce::Rectangle<float> fftBounds, double sampleRate);
-
-    juce::Path getPath() { return leftChannelFFTPath; }
+    /**
+     Turns whatever arrived in the ring into a new spectrum path, relative to
+     fftBounds' origin. False, leaving path alone, when nothing arrived.
+     */
+    bool process(juce::Rectangle<float> fftBounds, double sampleRate, juce::Path &path);
 
 private:
-    SingleChannelSampleFifo<BassQualizerAudioProcessor::BlockType> *leftChannelFifo;
+    SampleRing *leftChannelRing;
 
     juce::AudioBuffer<float> monoBuffer;
 
+    /** Shifts numSamples new samples into the end of monoBuffer. */
+    void appendToMonoBuffer(const float *samples, int numSamples);
+
     FFTDataGenerator<std::vector<float> > leftChannelFFTDataGenerator;
 
     AnalyzerPathGenerator<juce::Path> pathProducer;
+};
+
+/**
+ Runs a PathProducer at about 60 Hz on its own thread, so the FFT and the
+ path building stay off the message thread. The newest path is handed over
+ through a TripleBuffer: the editor only picks it up and draws it, and when
+ it can't keep up the frames in between are dropped, never queued.
+ */
+struct AnalyzerThread : juce::Thread {
+    AnalyzerThread(BassQualizerAudioProcessor &);
 
-    juce::Path leftChannelFFTPath;
+    ~AnalyzerThread() override;
+
+    void run() override;
+
+    /** Message thread: where the path goes, in the editor's coordinates. */
+    void setPathBounds(juce::Rectangle<float> bounds);
+
+    /** Message thread: takes the newest path, if a new one is ready. */
+    bool fetchPath() { return paths.fetch(); }
+
+    /** Message thread: the path taken by the last fetchPath. */
+    const juce::Path &getPath() const { return paths.getReadBuffer(); }
+
+private:
+    static constexpr int intervalMs = 16;
+
+    BassQualizerAudioProcessor &audioProcessor;
+    PathProducer pathProducer;
+    TripleBuffer<juce::Path> paths;
+
+    juce::SpinLock boundsLock;
+    juce::Rectangle<float> pathBounds;
 };
 
 struct CustomRotarySlider : juce::Slider {
@@ -251,7 +270,8 @@ private:
     BassQualizerAudioProcessor &audioProcessor;
     juce::Atomic<bool> parametersChanged{false};
 
-    MonoChain monoChain;
+    MonoChain monoChain, secondMonoChain;
+    bool showSecondSide = false;
 
     juce::Image background;
 
@@ -259,15 +279,34 @@ private:
 
     juce::Rectangle<int> getAnalysisArea();
 
-    SingleChannelSampleFifo<BassQualizerAudioProcessor::BlockType> *leftChannelFifo;
+    AnalyzerThread analyzerThread;
+};
 
-    juce::AudioBuffer<float> monoBuffer;
+/**
+ Input and output meters: RMS bars with decaying peak lines, the highest
+ true peak and the number of overs. A click clears the true peak and overs.
+ */
+struct LevelMeterComponent : juce::Component,
+                             juce::Timer {
+    LevelMeterComponent(BassQualizerAudioProcessor &);
 
-    FFTDataGenerator<std::vector<float> > leftChannelFFTDataGenerator;
+    void timerCallback() override;
 
-    AnalyzerPathGenerator<juce::Path> pathProducer;
+    void paint(juce::Graphics &g) override;
+
+    void mouseDown(const juce::MouseEvent &event) override;
 
-    juce::Path leftChannelFFTPath; // Add this line to declare leftChannelFFTPath
+private:
+    using Meter = LevelMeter<BassQualizerAudioProcessor::maxNumChannels>;
+
+    struct Display {
+        Meter *meter;
+        juce::String name;
+        float peak = 0.0f, truePeakHold = 0.0f, rms = 0.0f;
+        juce::uint32 overs = 0;
+    };
+
+    std::array<Display, 2> displays;
 };
 
 //==============================================================================
@@ -304,31 +343,102 @@ private:
 
     ResponseCurveComponent responseCurveComponent;
 
+    LevelMeterComponent levelMeterComponent;
+
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachment = APVTS::SliderAttachment;
 
-    Attachment peakFreqSliderAttachment,
-            peakGainSliderAttachment,
-            peakqualitySliderAttachment,
-            lowcutFreqSliderAttachment,
-            highcutFreqSliderAttachment,
-            lowcutSlopeSliderAttachment,
-            highcutSlopeSliderAttachment,
-            reverbRoomSizeAttachment,
-            reverbDampingAttachment,
-            reverbWetLevelAttachment,
-            reverbDryLevelAttachment,
-            reverbWidthAttachment;
-
     juce::ToggleButton lowcutBypassButton, peakBypassButton, highcutBypassButton, reverbBypassButton,
             reverbFreezeModeButton;
 
     using ButtonAttachment = APVTS::ButtonAttachment;
 
-    ButtonAttachment lowcutBypassButtonAttachment,
-            peakBypassButtonAttachment,
-            highcutBypassButtonAttachment,
-            reverbBypassButtonAttachment;;
+    // Processing options, shown in a row above the reverb section.
+    using ComboBoxAttachment = APVTS::ComboBoxAttachment;
+
+    juce::ComboBox filterTopologyBox, phaseModeBox, designMethodBox, lfoShapeBox, lfoTargetBox;
+
+    juce::Slider lfoRateSlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            lfoDepthSlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft};
+
+    juce::ToggleButton lfoAudioRateButton{"Audio Rate"};
+
+    juce::ToggleButton multirateBassButton{"Multirate Bass"};
+
+    std::vector<juce::Component *> getOptionComps();
+
+    // Dynamic peak and mono bass, in a second row below the options.
+    juce::ToggleButton peakDynamicButton{"Dynamic Peak"}, peakSidechainButton{"Sidechain"};
+
+    juce::Slider peakThresholdSlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            peakRatioSlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            peakAttackSlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            peakReleaseSlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft};
+
+    // Mono bass shares the row.
+    juce::ToggleButton monoBassButton{"Mono Bass"};
+
+    juce::Slider monoBassFreqSlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft};
+
+    std::vector<juce::Component *> getDynamicsComps();
+
+    // One row edits the band picked in bandSelectorBox; its attachments are
+    // recreated for each selection.
+    juce::ComboBox bandSelectorBox, bandTypeBox;
+
+    juce::ToggleButton bandActiveButton{"Active"};
+
+    juce::Slider bandFreqSlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            bandGainSlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            bandQualitySlider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft};
+
+    std::unique_ptr<ComboBoxAttachment> bandTypeAttachment;
+    std::unique_ptr<ButtonAttachment> bandActiveAttachment;
+    std::unique_ptr<Attachment> bandFreqAttachment, bandGainAttachment, bandQualityAttachment;
+
+    void selectBand(int band);
+
+    // Auto gain shares the band row.
+    juce::ToggleButton autoGainButton{"Auto Gain"}, autoGainFreezeButton{"Freeze Gain"};
+
+    std::vector<juce::Component *> getBandComps();
+
+    // Stereo mode, and the cuts and peak of the right or side channel, in a
+    // row of their own.
+    juce::ComboBox stereoModeBox, lowCutSlope2Box, highCutSlope2Box;
+
+    juce::ToggleButton lowCutBypass2Button{"LC 2 Bypass"},
+            peakBypass2Button{"Peak 2 Bypass"},
+            highCutBypass2Button{"HC 2 Bypass"};
+
+    juce::Slider lowCutFreq2Slider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            peakFreq2Slider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            peakGain2Slider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            peakQuality2Slider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft},
+            highCutFreq2Slider{juce::Slider::LinearBar, juce::Slider::TextBoxLeft};
+
+    std::vector<juce::Component *> getSecondSideComps();
+
+    // Reverb engine, next to the reverb bypass. The IR is picked with an
+    // async file chooser, which has to outlive the dialog.
+    juce::ComboBox reverbEngineBox;
+
+    juce::TextButton loadImpulseResponseButton{"Load IR..."};
+
+    juce::ToggleButton fdnHalfRateButton{"FDN Half Rate"};
+
+    // The attachments of every control above that has a fixed parameter,
+    // made from the table in attachControls(). Declared after the controls so
+    // they are destroyed first.
+    std::vector<std::unique_ptr<Attachment>> sliderAttachments;
+    std::vector<std::unique_ptr<ButtonAttachment>> buttonAttachments;
+    std::vector<std::unique_ptr<ComboBoxAttachment>> comboBoxAttachments;
+
+    void attachControls();
+
+    std::unique_ptr<juce::FileChooser> impulseResponseChooser;
+
+    void chooseImpulseResponse();
 
     // Custom look and feel
     myLookAndFeelV1 lookAndFeelV1;
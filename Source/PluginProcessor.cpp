@@ -8,6 +8,12 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "LinearPhaseEQ.h"
+#include "ConvolutionReverb.h"
+
+namespace {
+    const juce::Identifier impulseResponseProperty{"impulseResponse"};
+}
 
 //==============================================================================
 BassQualizerAudioProcessor::BassQualizerAudioProcessor()
@@ -16,15 +22,19 @@ BassQualizerAudioProcessor::BassQualizerAudioProcessor()
 #if ! JucePlugin_IsMidiEffect
 #if ! JucePlugin_IsSynth
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
+        .withInput("Sidechain", juce::AudioChannelSet::stereo(), false)
 #endif
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
     )
 #endif
 {
+    linearPhaseEQ = std::make_unique<LinearPhaseEQ>();
+    convolutionReverb = std::make_unique<ConvolutionReverb>();
 }
 
 BassQualizerAudioProcessor::~BassQualizerAudioProcessor() {
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -57,7 +67,7 @@ bool BassQualizerAudioProcessor::isMidiEffect() const {
 }
 
 double BassQualizerAudioProcessor::getTailLengthSeconds() const {
-    return 0.0;
+    return tailLengthSeconds;
 }
 
 int BassQualizerAudioProcessor::getNumPrograms() {
@@ -85,24 +95,87 @@ void BassQualizerAudioProcessor::prepareToPlay(double sampleRate, int samplesPer
     // initialisation that you need..
     juce::dsp::ProcessSpec spec;
 
+    // Hosts don't always keep to samplesPerBlock (offline renders in
+    // particular), see processSamples.
+    samplesPerBlock = juce::jmax(1, samplesPerBlock);
+    preparedBlockSize = samplesPerBlock;
+
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
+    spec.numChannels = 2;
     spec.sampleRate = sampleRate;
 
-    reverb.prepare(spec);
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    for (auto &reverb: reverbs) {
+        reverb.prepare(spec);
+        reverb.reset();
+    }
+
+    forEachFdnReverb([&spec](auto &reverb) { reverb.prepare(spec); });
+
+    // the convolution engines are prepared for the bus as it is laid out now
+    spec.numChannels = (juce::uint32) juce::jlimit(1, maxNumChannels, getMainBusNumInputChannels());
+
+    convolutionReverb->prepare(spec);
+    convolutionReverb->reset();
+
+    reverbDryGain = lastChainSettings.reverbDryLevel * reverbDryScale;
+    reverbSkipped = false;
+
+    floatGroups.prepare(sampleRate, samplesPerBlock);
+    doubleGroups.prepare(sampleRate, samplesPerBlock);
+
+    peakDynamics.prepare(sampleRate, samplesPerBlock);
+    peakDynamicGain = designedPeakDynamicGain = 0.0f;
+
+    floatScratch.setSize(maxNumChannels, samplesPerBlock);
+
+    loudnessMatch.prepare(sampleRate, samplesPerBlock);
+    inputMeter.prepare(sampleRate);
+    outputMeter.prepare(sampleRate);
+    autoGainSmoother.reset(sampleRate, autoGainRampSeconds);
+    autoGainSmoother.setCurrentAndTargetValue(1.0f);
+
+    for (auto &smoothers: sideSmoothers)
+        smoothers.reset(sampleRate, smoothingTimeSeconds);
+
+    for (auto &smoothers: bandSmoothers) {
+        smoothers.freq.reset(sampleRate, smoothingTimeSeconds);
+        smoothers.quality.reset(sampleRate, smoothingTimeSeconds);
+        smoothers.gain.reset(sampleRate, smoothingTimeSeconds);
+    }
+
+    monoBassFreqSmoother.reset(sampleRate, smoothingTimeSeconds);
+
+    juce::dsp::ProcessSpec linearPhaseSpec;
+    linearPhaseSpec.maximumBlockSize = (juce::uint32) samplesPerBlock;
+    linearPhaseSpec.numChannels = (juce::uint32) juce::jlimit(1, maxNumChannels, getMainBusNumInputChannels());
+    linearPhaseSpec.sampleRate = sampleRate;
+
+    linearPhaseEQ->prepare(linearPhaseSpec);
+    linearPhaseEQ->reset();
+
+    // the chains were just prepared, there is nothing to fade from (and the
+    // table's length follows the sample rate)
+    cancelSwitchFade();
+    switchFadeGains.resize((size_t) juce::jmax(1, juce::roundToInt(switchFadeSeconds * sampleRate)));
+    for (size_t i = 0; i < switchFadeGains.size(); ++i)
+        switchFadeGains[i] = (float) std::sin(juce::MathConstants<double>::halfPi * (i + 0.5) / switchFadeGains.size());
+
+    forceFilterUpdate = true;
 
     updateFilters();
+    setLatencySamples(pendingLatency);
 
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    osc.initialise([this](float phase) { return evaluateLfoShape(lastChainSettings.lfoShape, phase); });
 
-    osc.initialise([](float x) { return std::sin(x); });
+    juce::dsp::ProcessSpec lfoSpec;
+    lfoSpec.sampleRate = sampleRate / audioRateBlockSize;
+    lfoSpec.maximumBlockSize = (juce::uint32) samplesPerBlock;
+    lfoSpec.numChannels = 1;
 
-    spec.numChannels = getTotalNumOutputChannels();
-    osc.prepare(spec);
-    osc.setFrequency(200);
+    osc.prepare(lfoSpec);
+    osc.setFrequency(lastChainSettings.lfoRate, true);
+    lfoValue = 0.0f;
+    samplesUntilControlTick = 0;
 
 }
 
@@ -117,18 +190,20 @@ bool BassQualizerAudioProcessor::isBusesLayoutSupported(const BusesLayout &layou
     juce::ignoreUnused (layouts);
     return true;
 #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout from mono up to maxNumChannels is supported, every channel
+    // gets its own lane in the SIMD filter chains.
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels == 0 || numChannels > maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
 #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // the peak detector listens to a mono or stereo sidechain, if any
+    if (layouts.inputBuses.size() > 1 && layouts.getChannelSet(true, 1).size() > 2)
+        return false;
 #endif
 
     return true;
@@ -137,7 +212,38 @@ bool BassQualizerAudioProcessor::isBusesLayoutSupported(const BusesLayout &layou
 #endif
 
 void BassQualizerAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages) {
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
+
+void BassQualizerAudioProcessor::processBlock(juce::AudioBuffer<double> &buffer, juce::MidiBuffer &midiMessages) {
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
+
+template<typename SampleType>
+void BassQualizerAudioProcessor::processSamples(juce::AudioBuffer<SampleType> &buffer) {
     juce::ScopedNoDenormals noDenormals;
+    const auto numSamples = buffer.getNumSamples();
+
+    // (before prepareToPlay there is nothing to slice for)
+    if (numSamples <= preparedBlockSize || preparedBlockSize == 0) {
+        processSlice(buffer);
+        return;
+    }
+
+    // A block longer than announced runs as slices of the prepared size.
+    // The slices refer to the host's channels; with up to 32 channels
+    // AudioBuffer keeps the channel pointers inline, so nothing allocates.
+    for (int start = 0; start < numSamples; start += preparedBlockSize) {
+        juce::AudioBuffer<SampleType> slice(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start,
+                                            juce::jmin(preparedBlockSize, numSamples - start));
+        processSlice(slice);
+    }
+}
+
+template<typename SampleType>
+void BassQualizerAudioProcessor::processSlice(juce::AudioBuffer<SampleType> &buffer) {
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -152,22 +258,456 @@ void BassQualizerAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
 
     updateFilters();
 
-    juce::dsp::AudioBlock<float> block(buffer);
+    // the sidechain's channels follow the main input's, only the latter are processed
+    const auto numChannels = juce::jmin(getMainBusNumInputChannels(), buffer.getNumChannels(), maxNumChannels);
+    const auto numSamples = buffer.getNumSamples();
+
+    const auto inputSilent = isSilent(buffer, numChannels, numSamples);
+    silentSamples = inputSilent ? silentSamples + numSamples : 0;
+
+    if (idle && inputSilent) {
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.clear(channel, 0, numSamples);
+
+        inputMeter.processSilence(numSamples);
+        outputMeter.processSilence(numSamples);
+    } else {
+        idle = false;
+        inputMeter.process(buffer, numChannels, numSamples);
+
+        const auto measureLoudness = lastChainSettings.autoGain && !lastChainSettings.autoGainFreeze;
+
+        if (measureLoudness)
+            loudnessMatch.pushInput(buffer, numChannels, numSamples);
+
+        processStages(buffer, numChannels);
+
+        if (lastChainSettings.autoGain)
+            applyAutoGain(buffer, numChannels);
+
+        outputMeter.process(buffer, numChannels, numSamples);
+
+        // the input has been silent for longer than anything can ring, and the
+        // output agrees: stop processing until there is input again
+        const auto tailSamples = tailLengthSeconds.load() * getSampleRate();
+
+        if (inputSilent && (double) silentSamples >= tailSamples && isSilent(buffer, numChannels, numSamples)) {
+            idle = true;
+            resetProcessingState();
+        }
+    }
+
+    if (buffer.getNumChannels() > Channel::Left)
+        leftChannelRing.write(buffer.getReadPointer(Channel::Left), numSamples);
+}
+
+template<typename SampleType>
+void BassQualizerAudioProcessor::processStages(juce::AudioBuffer<SampleType> &buffer, int numChannels) {
+    const auto numSamples = buffer.getNumSamples();
+
+    // Neutral settings bypass the filters once nothing is ramping any more.
+    // Their states are stale when they come back, so they restart from silence.
+    const auto skipFilters = neutral && !isSmoothing();
+
+    if (filtersSkipped && !skipFilters)
+        forActiveGroups([](auto &groups) {
+            groups.resetChains();
+            groups.resetMultirateBands();
+        });
+
+    filtersSkipped = skipFilters;
+
+    if (skipFilters) {
+        // the input passes through untouched
+    } else if (lastChainSettings.phaseMode == PhaseMode::Linear) {
+        processInFloat(buffer, numChannels, [this](juce::dsp::AudioBlock<float> &block) {
+            linearPhaseEQ->process(juce::dsp::ProcessContextReplacing<float>(block));
+        });
+    } else {
+        auto &groups = getGroups<SampleType>();
+
+        if (usesPeakDynamics(lastChainSettings))
+            analysePeakLevel(buffer, numChannels);
+
+        const auto midSide = lastChainSettings.stereoMode == StereoMode::MidSide;
+
+        groups.interleave(buffer, numChannels, numSamples, midSide);
+        processChannelGroups(groups, numChannels, numSamples);
+        groups.deinterleave(buffer, numChannels, numSamples, midSide);
+    }
+
+    if (!lastChainSettings.reverbBypassed)
+        processReverb(buffer, numChannels);
+    else
+        reverbSkipped = true;
+}
+
+template<typename SampleType>
+void BassQualizerAudioProcessor::processReverb(juce::AudioBuffer<SampleType> &buffer, int numChannels) {
+    const auto dryGain = lastChainSettings.reverbDryLevel * reverbDryScale;
+
+    // Nothing wet reaches the output, so only the dry gain is left to apply.
+    // The reverbs aren't fed meanwhile and restart from silence afterwards.
+    if (lastChainSettings.reverbWetLevel == 0.0f) {
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.applyGainRamp(channel, 0, buffer.getNumSamples(), (SampleType) reverbDryGain, (SampleType) dryGain);
+
+        reverbDryGain = dryGain;
+        reverbSkipped = true;
+        return;
+    }
+
+    if (reverbSkipped) {
+        for (auto &reverb: reverbs)
+            reverb.reset();
+
+        for (auto &reverb: getFdnReverbs<SampleType>())
+            reverb.reset();
+
+        convolutionReverb->reset();
+        reverbSkipped = false;
+    }
+
+    reverbDryGain = dryGain;
+
+    if (lastChainSettings.reverbEngine == ReverbEngine::Convolution) {
+        processInFloat(buffer, numChannels, [this](juce::dsp::AudioBlock<float> &block) {
+            convolutionReverb->process(juce::dsp::ProcessContextReplacing<float>(block));
+        });
+        return;
+    }
+
+    // FdnReverb runs on the buffer as it is, juce::dsp::Reverb only in float
+    if (lastChainSettings.reverbEngine == ReverbEngine::Fdn) {
+        auto block = juce::dsp::AudioBlock<SampleType>(buffer).getSubsetChannelBlock(0, (size_t) numChannels);
+        processReverbPairs(getFdnReverbs<SampleType>(), block);
+        return;
+    }
+
+    processInFloat(buffer, numChannels, [this](juce::dsp::AudioBlock<float> &block) {
+        processReverbPairs(reverbs, block);
+    });
+}
+
+template<typename Reverbs, typename SampleType>
+void BassQualizerAudioProcessor::processReverbPairs(Reverbs &pairReverbs, juce::dsp::AudioBlock<SampleType> &block) {
+    const auto numBlockChannels = block.getNumChannels();
+
+    // pairs go through processStereo, where the width setting applies
+    for (size_t pair = 0; pair * 2 < numBlockChannels; ++pair) {
+        auto pairBlock = block.getSubsetChannelBlock(pair * 2, juce::jmin((size_t) 2, numBlockChannels - pair * 2));
+        pairReverbs[pair].process(juce::dsp::ProcessContextReplacing<SampleType>(pairBlock));
+    }
+}
+
+template<typename SampleType>
+void BassQualizerAudioProcessor::applyAutoGain(juce::AudioBuffer<SampleType> &buffer, int numChannels) {
+    const auto numSamples = buffer.getNumSamples();
+
+    if (!lastChainSettings.autoGainFreeze) {
+        loudnessMatch.pushOutput(buffer, numChannels, numSamples);
+        autoGainSmoother.setTargetValue(juce::Decibels::decibelsToGain(loudnessMatch.getGainDecibels()));
+    }
+
+    const auto startGain = (SampleType) autoGainSmoother.getCurrentValue();
+    autoGainSmoother.skip(numSamples);
+    const auto endGain = (SampleType) autoGainSmoother.getCurrentValue();
+
+    if (startGain == SampleType(1) && endGain == SampleType(1))
+        return;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        buffer.applyGainRamp(channel, 0, numSamples, startGain, endGain);
+}
+
+template<typename SampleType>
+void BassQualizerAudioProcessor::analysePeakLevel(juce::AudioBuffer<SampleType> &buffer, int numChannels) {
+    if (lastChainSettings.peakSidechain && getChannelCountOfBus(true, 1) > 0) {
+        auto sidechain = getBusBuffer(buffer, true, 1);
+        peakDynamics.analyse(sidechain, sidechain.getNumChannels(), buffer.getNumSamples());
+    } else {
+        peakDynamics.analyse(buffer, numChannels, buffer.getNumSamples());
+    }
+}
+
+template<typename SampleType>
+bool BassQualizerAudioProcessor::isSilent(const juce::AudioBuffer<SampleType> &buffer,
+                                          int numChannels, int numSamples) {
+    for (int channel = 0; channel < numChannels; ++channel) {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(channel), numSamples);
+
+        if (range.getStart() < -silenceThreshold || range.getEnd() > silenceThreshold)
+            return false;
+    }
+
+    return true;
+}
+
+void BassQualizerAudioProcessor::resetProcessingState() {
+    forActiveGroups([](auto &groups) {
+        groups.resetChains();
+        groups.resetMultirateBands();
+    });
+
+    cancelSwitchFade();
+
+    linearPhaseEQ->reset();
+
+    for (auto &reverb: reverbs)
+        reverb.reset();
+
+    // the other precision's FDN is reset by prepareToPlay before it runs
+    const auto resetFdn = [](auto &fdnReverbs) {
+        for (auto &reverb: fdnReverbs)
+            reverb.reset();
+    };
+
+    if (isUsingDoublePrecision())
+        resetFdn(doubleFdnReverbs);
+    else
+        resetFdn(floatFdnReverbs);
+
+    convolutionReverb->reset();
+}
+
+bool BassQualizerAudioProcessor::isSmoothing() const {
+    const auto bandSmoothing = std::any_of(bandSmoothers.begin(), bandSmoothers.end(), [](const auto &smoothers) {
+        return smoothers.freq.isSmoothing() || smoothers.quality.isSmoothing() || smoothers.gain.isSmoothing();
+    });
+
+    return sideSmoothers[0].isSmoothing() || sideSmoothers[1].isSmoothing() || bandSmoothing
+           || monoBassFreqSmoother.isSmoothing() || switchFadeRemaining > 0;
+}
+
+double BassQualizerAudioProcessor::computeTailLengthSeconds(const ChainSettings &chainSettings) const {
+    const auto reverbIsWet = !chainSettings.reverbBypassed && chainSettings.reverbWetLevel > 0.0f;
+
+    if (reverbIsWet && chainSettings.reverbEngine != ReverbEngine::Convolution && chainSettings.reverbFreezeMode)
+        return std::numeric_limits<double>::infinity();
+
+    // A resonance with quality Q at frequency f decays by 1/e every
+    // Q / (pi f) seconds; the tail ends once it is 100 dB down.
+    constexpr auto nepers = 11.5;
+    const auto pi = juce::MathConstants<double>::pi;
+
+    // modulation can take the cuts down to frequency / 2^depth
+    const auto lowestRatio = chainSettings.lfoTarget != LfoTarget::Off ? std::exp2(-chainSettings.lfoDepth) : 1.0;
+    auto ringTime = [&](double frequency, double Q) { return nepers * Q / (pi * frequency * lowestRatio); };
+
+    double tail = 0.0;
+
+    for (const auto &side: {chainSettings, getSecondSide(chainSettings)}) {
+        if (!side.lowCutBypassed) {
+            const auto order = 2 * (side.lowCutSlope + 1);
+            tail = juce::jmax(tail, ringTime(side.lowCutFreq, getButterworthQ(order, order / 2 - 1)));
+        }
+
+        if (!side.highCutBypassed) {
+            const auto order = 2 * (side.highCutSlope + 1);
+            tail = juce::jmax(tail, ringTime(side.highCutFreq, getButterworthQ(order, order / 2 - 1)));
+        }
+
+        if (!side.peakBypassed) {
+            const auto gainFactor = juce::Decibels::decibelsToGain(side.peakGainInDecibels);
+            tail = juce::jmax(tail, ringTime(side.peakFreq, side.peakQuality * std::sqrt(gainFactor)));
+        }
+    }
+
+    for (const auto &band: chainSettings.bands) {
+        if (!band.active)
+            continue;
+
+        const auto gainFactor = juce::Decibels::decibelsToGain(band.gainInDecibels);
+        const auto Q = band.type == BandType::Peak ? band.quality * std::sqrt(gainFactor) : band.quality;
+        tail = juce::jmax(tail, nepers * Q / (pi * band.freq));
+    }
+
+    if (chainSettings.monoBass)
+        tail = juce::jmax(tail, nepers * MonoMaker<float>::crossoverQ / (pi * chainSettings.monoBassFreq));
+
+    if (reverbIsWet && chainSettings.reverbEngine == ReverbEngine::Convolution) {
+        tail = juce::jmax(tail, convolutionReverb->getTailLengthSeconds());
+    } else if (reverbIsWet) {
+        // juce::Reverb: the longest comb is 1617 + 23 samples at 44.1 kHz (it
+        // scales with the sample rate), with feedback roomSize * 0.28 + 0.7.
+        // FdnReverb decays at the same rate.
+        constexpr auto longestCombSeconds = 1640.0 / 44100.0;
+        const auto feedback = chainSettings.reverbRoomSize * 0.28 + 0.7;
+        tail = juce::jmax(tail, nepers / -std::log(feedback) * longestCombSeconds);
+    }
+
+    // whatever is still inside a delay line comes out after the tail
+    return tail + pendingLatency.load() / getSampleRate();
+}
+
+template<typename SampleType, typename Function>
+void BassQualizerAudioProcessor::processInFloat(juce::AudioBuffer<SampleType> &buffer, int numChannels,
+                                                Function &&function) {
+    const auto numSamples = buffer.getNumSamples();
+
+    if constexpr (std::is_same_v<SampleType, float>) {
+        auto block = juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(0, (size_t) numChannels);
+        function(block);
+    } else {
+        jassert(numSamples <= floatScratch.getNumSamples());
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            auto *source = buffer.getReadPointer(channel);
+            auto *destination = floatScratch.getWritePointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (float) source[i];
+        }
+
+        auto block = juce::dsp::AudioBlock<float>(floatScratch).getSubsetChannelBlock(0, (size_t) numChannels)
+                .getSubBlock(0, (size_t) numSamples);
+        function(block);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            auto *source = floatScratch.getReadPointer(channel);
+            auto *destination = buffer.getWritePointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (double) source[i];
+        }
+    }
+}
+
+template<typename Groups>
+void BassQualizerAudioProcessor::processChannelGroups(Groups &groups, int numChannels, int numSamples) {
+    using Vector = typename Groups::Vector;
+
+    const auto numGroups = groups.getNumGroups(numChannels);
+
+    for (int start = 0; start < numSamples;) {
+        if (samplesUntilControlTick == 0) {
+            if (usesPeakDynamics(lastChainSettings))
+                peakDynamicGain = peakDynamics.getGainDecibels(start);
+
+            samplesUntilControlTick = getControlBlockSize();
+            updateSmoothedFilters(samplesUntilControlTick);
+        }
+
+        const auto subBlockSize = juce::jmin(samplesUntilControlTick, numSamples - start);
+        const auto multirate = usesMultirateBands();
+        const auto stateVariable = lastChainSettings.filterTopology == FilterTopology::StateVariable;
+        const auto monoBass = lastChainSettings.monoBass;
+        const auto midSide = lastChainSettings.stereoMode == StereoMode::MidSide;
+
+        for (int group = 0; group < numGroups; ++group) {
+            auto groupBlock = groups.interleavedBlock.getSingleChannelBlock((size_t) group)
+                    .getSubBlock((size_t) start, (size_t) subBlockSize);
+            juce::dsp::ProcessContextReplacing<Vector> groupContext(groupBlock);
+
+            // a group without a pair (mono) has nothing to sum
+            const auto numPairs = groups.getNumPairs(group, numChannels);
+
+            if (monoBass && numPairs > 0)
+                groups.monoMakers[(size_t) group].process(groupContext, numPairs, midSide);
+
+            if (multirate)
+                groups.multirateBands[(size_t) group].process(groupContext);
+
+            // the held chains get the same input as the new ones
+            auto heldBlock = groups.heldBlock.getSingleChannelBlock(0).getSubBlock(0, (size_t) subBlockSize);
+            auto olderHeldBlock = groups.heldBlock.getSingleChannelBlock(1).getSubBlock(0, (size_t) subBlockSize);
+
+            if (switchFadeRemaining > 0) {
+                std::copy(groupBlock.getChannelPointer(0), groupBlock.getChannelPointer(0) + subBlockSize,
+                          heldBlock.getChannelPointer(0));
+
+                if (heldFadeRemaining > 0) {
+                    std::copy(groupBlock.getChannelPointer(0), groupBlock.getChannelPointer(0) + subBlockSize,
+                              olderHeldBlock.getChannelPointer(0));
+                    processHeldChains(groups, group, 1, olderHeldBlock);
+                }
+
+                processHeldChains(groups, group, 0, heldBlock);
+
+                if (heldFadeRemaining > 0)
+                    mixSwitchFade(heldBlock, olderHeldBlock, heldFadeRemaining);
+            }
+
+            if (stateVariable)
+                groups.svfChains[(size_t) group].process(groupContext);
+            else
+                groups.chains[(size_t) group].process(groupContext);
+
+            if (switchFadeRemaining > 0)
+                mixSwitchFade(groupBlock, heldBlock, switchFadeRemaining);
+        }
+
+        heldFadeRemaining = juce::jmax(0, heldFadeRemaining - subBlockSize);
+        switchFadeRemaining = juce::jmax(0, switchFadeRemaining - subBlockSize);
+        samplesUntilControlTick -= subBlockSize;
+        start += subBlockSize;
+    }
+}
+
+template<typename Groups>
+void BassQualizerAudioProcessor::processHeldChains(Groups &groups, int group, int set,
+                                                   juce::dsp::AudioBlock<typename Groups::Vector> &block) {
+    // from skipped filters, the dry copy is what fades out
+    if (fadeFromDry[(size_t) set])
+        return;
+
+    juce::dsp::ProcessContextReplacing<typename Groups::Vector> context(block);
+    auto &held = groups.held[(size_t) set];
+
+    if (fadeTopology[(size_t) set] == FilterTopology::StateVariable)
+        held.svfChains[(size_t) group].process(context);
+    else
+        held.chains[(size_t) group].process(context);
+}
+
+void BassQualizerAudioProcessor::beginSwitchFade() {
+    // the fade that is running becomes part of what fades out, from where it is
+    const auto keepFade = switchFadeRemaining > 0;
+    jassert(heldFadeRemaining == 0);
+
+    if (keepFade) {
+        fadeFromDry[1] = fadeFromDry[0];
+        fadeTopology[1] = fadeTopology[0];
+        heldFadeRemaining = switchFadeRemaining;
+    }
 
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    fadeFromDry[0] = filtersSkipped;
+    fadeTopology[0] = lastChainSettings.filterTopology;
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    forActiveGroups([this, keepFade](auto &groups) {
+        groups.holdChains(fadeTopology[0], keepFade);
+    });
+
+    switchFadeRemaining = (int) switchFadeGains.size();
+}
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+void BassQualizerAudioProcessor::cancelSwitchFade() {
+    switchFadeRemaining = 0;
+    heldFadeRemaining = 0;
+}
 
-    reverb.process(leftContext);
-    reverb.process(rightContext);
+template<typename Vector>
+void BassQualizerAudioProcessor::mixSwitchFade(juce::dsp::AudioBlock<Vector> &block,
+                                               const juce::dsp::AudioBlock<Vector> &held, int remaining) const {
+    // fade in with gains[k], out with gains[length - 1 - k]: sin and cos of
+    // the same angle
+    const auto length = (int) switchFadeGains.size();
+    const auto position = length - remaining;
+    const auto numSamples = juce::jmin((int) block.getNumSamples(), remaining);
+
+    auto *output = block.getChannelPointer(0);
+    const auto *previous = held.getChannelPointer(0);
+
+    for (int i = 0; i < numSamples; ++i) {
+        const auto fadeIn = broadcast<Vector>(switchFadeGains[(size_t) (position + i)]);
+        const auto fadeOut = broadcast<Vector>(switchFadeGains[(size_t) (length - 1 - position - i)]);
+        output[i] = output[i] * fadeIn + previous[i] * fadeOut;
+    }
+}
 
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+int BassQualizerAudioProcessor::getControlBlockSize() const {
+    const auto audioRateModulation = lastChainSettings.lfoTarget != LfoTarget::Off && lastChainSettings.lfoAudioRate;
+    return audioRateModulation ? audioRateBlockSize : controlBlockSize;
 }
 
 //==============================================================================
@@ -197,79 +737,527 @@ void BassQualizerAudioProcessor::setStateInformation(const void *data, int sizeI
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
     if (tree.isValid()) {
         apvts.replaceState(tree);
-        updateFilters();
+        forceFilterUpdate = true;
+        stateLoaded = true;
+
+        const auto file = getImpulseResponseFile();
+        if (file.existsAsFile())
+            convolutionReverb->loadImpulseResponse(file);
+    }
+
+}
+
+void BassQualizerAudioProcessor::loadImpulseResponse(const juce::File &file) {
+    apvts.state.setProperty(impulseResponseProperty, file.getFullPathName(), nullptr);
+    convolutionReverb->loadImpulseResponse(file);
+}
+
+juce::File BassQualizerAudioProcessor::getImpulseResponseFile() const {
+    const auto path = apvts.state.getProperty(impulseResponseProperty).toString();
+    return path.isNotEmpty() ? juce::File(path) : juce::File();
+}
+
+namespace {
+    /** A raw parameter value as the type of the settings field it lands in. */
+    template<typename Field>
+    Field fromRawValue(float value) {
+        if constexpr (std::is_same_v<Field, float>)
+            return value;
+        else if constexpr (std::is_same_v<Field, bool>)
+            return value > 0.5f;
+        else
+            return static_cast<Field>(juce::roundToInt(value));
+    }
+
+    template<auto Field>
+    void readField(ChainSettings &settings, float value) {
+        auto &field = settings.*Field;
+        field = fromRawValue<std::decay_t<decltype(field)>>(value);
     }
-    
+
+    template<auto Field>
+    void readSecondField(ChainSettings &settings, float value) {
+        auto &field = settings.second.*Field;
+        field = fromRawValue<std::decay_t<decltype(field)>>(value);
+    }
+
+    template<auto Field>
+    void readBandField(BandSettings &band, float value) {
+        auto &field = band.*Field;
+        field = fromRawValue<std::decay_t<decltype(field)>>(value);
+    }
+
+    struct FieldBinding {
+        Param param;
+        void (*read)(ChainSettings &, float);
+    };
+
+    // Where each fixed parameter lands in ChainSettings, in Param order like
+    // fixedParameterDescriptors.
+    constexpr std::array<FieldBinding, (size_t) Param::firstBandParam> fieldBindings{
+        {
+            {Param::lowCutFreq, readField<&ChainSettings::lowCutFreq>},
+            {Param::highCutFreq, readField<&ChainSettings::highCutFreq>},
+            {Param::peakFreq, readField<&ChainSettings::peakFreq>},
+            {Param::peakGainInDb, readField<&ChainSettings::peakGainInDecibels>},
+            {Param::peakQuality, readField<&ChainSettings::peakQuality>},
+            {Param::lowCutSlope, readField<&ChainSettings::lowCutSlope>},
+            {Param::highCutSlope, readField<&ChainSettings::highCutSlope>},
+            {Param::lowCutBypass, readField<&ChainSettings::lowCutBypassed>},
+            {Param::peakBypass, readField<&ChainSettings::peakBypassed>},
+            {Param::highCutBypass, readField<&ChainSettings::highCutBypassed>},
+            {Param::reverbRoomSize, readField<&ChainSettings::reverbRoomSize>},
+            {Param::reverbDamping, readField<&ChainSettings::reverbDamping>},
+            {Param::reverbWetLevel, readField<&ChainSettings::reverbWetLevel>},
+            {Param::reverbDryLevel, readField<&ChainSettings::reverbDryLevel>},
+            {Param::reverbWidth, readField<&ChainSettings::reverbWidth>},
+            {Param::reverbFreezeMode, readField<&ChainSettings::reverbFreezeMode>},
+            {Param::reverbBypass, readField<&ChainSettings::reverbBypassed>},
+            {Param::filterTopology, readField<&ChainSettings::filterTopology>},
+            {Param::lfoRate, readField<&ChainSettings::lfoRate>},
+            {Param::lfoDepth, readField<&ChainSettings::lfoDepth>},
+            {Param::lfoShape, readField<&ChainSettings::lfoShape>},
+            {Param::lfoTarget, readField<&ChainSettings::lfoTarget>},
+            {Param::lfoAudioRate, readField<&ChainSettings::lfoAudioRate>},
+            {Param::phaseMode, readField<&ChainSettings::phaseMode>},
+            {Param::designMethod, readField<&ChainSettings::designMethod>},
+            {Param::multirateBass, readField<&ChainSettings::multirateBass>},
+            {Param::reverbEngine, readField<&ChainSettings::reverbEngine>},
+            {Param::fdnHalfRate, readField<&ChainSettings::fdnHalfRate>},
+            {Param::peakDynamic, readField<&ChainSettings::peakDynamic>},
+            {Param::peakThreshold, readField<&ChainSettings::peakThreshold>},
+            {Param::peakRatio, readField<&ChainSettings::peakRatio>},
+            {Param::peakAttack, readField<&ChainSettings::peakAttack>},
+            {Param::peakRelease, readField<&ChainSettings::peakRelease>},
+            {Param::peakSidechain, readField<&ChainSettings::peakSidechain>},
+            {Param::stereoMode, readField<&ChainSettings::stereoMode>},
+            {Param::lowCutFreq2, readSecondField<&SecondSideSettings::lowCutFreq>},
+            {Param::highCutFreq2, readSecondField<&SecondSideSettings::highCutFreq>},
+            {Param::peakFreq2, readSecondField<&SecondSideSettings::peakFreq>},
+            {Param::peakGainInDb2, readSecondField<&SecondSideSettings::peakGainInDecibels>},
+            {Param::peakQuality2, readSecondField<&SecondSideSettings::peakQuality>},
+            {Param::lowCutSlope2, readSecondField<&SecondSideSettings::lowCutSlope>},
+            {Param::highCutSlope2, readSecondField<&SecondSideSettings::highCutSlope>},
+            {Param::lowCutBypass2, readSecondField<&SecondSideSettings::lowCutBypassed>},
+            {Param::peakBypass2, readSecondField<&SecondSideSettings::peakBypassed>},
+            {Param::highCutBypass2, readSecondField<&SecondSideSettings::highCutBypassed>},
+            {Param::monoBass, readField<&ChainSettings::monoBass>},
+            {Param::monoBassFreq, readField<&ChainSettings::monoBassFreq>},
+            {Param::autoGain, readField<&ChainSettings::autoGain>},
+            {Param::autoGainFreeze, readField<&ChainSettings::autoGainFreeze>},
+        }
+    };
+
+    constexpr std::array<void (*)(BandSettings &, float), (size_t) BandParam::numBandParams> bandFieldReaders{
+        readBandField<&BandSettings::active>,
+        readBandField<&BandSettings::type>,
+        readBandField<&BandSettings::freq>,
+        readBandField<&BandSettings::gainInDecibels>,
+        readBandField<&BandSettings::quality>,
+    };
+
+    constexpr bool fieldBindingsMatchParamOrder() {
+        for (size_t i = 0; i < fieldBindings.size(); ++i)
+            if ((size_t) fieldBindings[i].param != i || fieldBindings[i].read == nullptr)
+                return false;
+
+        return true;
+    }
+
+    static_assert(fieldBindingsMatchParamOrder(), "every fixed parameter needs a field binding, in Param order");
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState &apvts) {
+ChainSettings getChainSettings(const ParameterHandles &parameters) {
     ChainSettings settings;
 
-    settings.lowCutFreq = apvts.getRawParameterValue("lowCutFreq")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("highCutFreq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("peakFreq")->load();
-    settings.peakGainInDecibels = apvts.getRawParameterValue("peakGainInDb")->load();
-    settings.peakQuality = apvts.getRawParameterValue("peakQuality")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("lowCutSlope")->load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("highCutSlope")->load());
-    settings.lowCutBypassed = apvts.getRawParameterValue("lowCutBypass")->load() > 0.5f;
-    settings.peakBypassed = apvts.getRawParameterValue("peakBypass")->load() > 0.5f;
-    settings.highCutBypassed = apvts.getRawParameterValue("highCutBypass")->load() > 0.5f;
-    settings.reverbRoomSize = apvts.getRawParameterValue("reverbRoomSize")->load();
-    settings.reverbDamping = apvts.getRawParameterValue("reverbDamping")->load();
-    settings.reverbWetLevel = apvts.getRawParameterValue("reverbWetLevel")->load();
-    settings.reverbDryLevel = apvts.getRawParameterValue("reverbDryLevel")->load();
-    settings.reverbWidth = apvts.getRawParameterValue("reverbWidth")->load();
-    settings.reverbBypassed = apvts.getRawParameterValue("reverbBypass")->load() > 0.5f;
-    settings.reverbFreezeMode = apvts.getRawParameterValue("reverbFreezeMode")->load() > 0.5f;
+    for (const auto &binding: fieldBindings)
+        binding.read(settings, parameters.get(binding.param));
+
+    for (int i = 0; i < numBands; ++i)
+        for (int field = 0; field < (int) BandParam::numBandParams; ++field)
+            bandFieldReaders[(size_t) field](settings.bands[(size_t) i],
+                                             parameters.get(getBandParam(i, static_cast<BandParam>(field))));
 
     return settings;
 }
 
-Coefficients makePeakFilter(const ChainSettings &chainSettings, double sampleRate) 
-{
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-        chainSettings.peakFreq,
-        chainSettings.peakQuality,
-        juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+ChainSettings getSecondSide(const ChainSettings &chainSettings) {
+    auto side = chainSettings;
+
+    if (chainSettings.stereoMode == StereoMode::Linked)
+        return side;
+
+    side.peakFreq = chainSettings.second.peakFreq;
+    side.peakGainInDecibels = chainSettings.second.peakGainInDecibels;
+    side.peakQuality = chainSettings.second.peakQuality;
+    side.lowCutFreq = chainSettings.second.lowCutFreq;
+    side.highCutFreq = chainSettings.second.highCutFreq;
+    side.lowCutSlope = chainSettings.second.lowCutSlope;
+    side.highCutSlope = chainSettings.second.highCutSlope;
+    side.lowCutBypassed = chainSettings.second.lowCutBypassed;
+    side.peakBypassed = chainSettings.second.peakBypassed;
+    side.highCutBypassed = chainSettings.second.highCutBypassed;
+
+    return side;
+}
+
+namespace {
+    // The sides only need designs of their own when their settings differ;
+    // two bypassed sides are the same whatever else they hold.
+    bool lowCutSidesDiffer(const ChainSettings &first, const ChainSettings &second) {
+        return lowCutSettingsChanged(first, second) && !(first.lowCutBypassed && second.lowCutBypassed);
+    }
+
+    bool highCutSidesDiffer(const ChainSettings &first, const ChainSettings &second) {
+        return highCutSettingsChanged(first, second) && !(first.highCutBypassed && second.highCutBypassed);
+    }
+
+    bool peakSidesDiffer(const ChainSettings &first, const ChainSettings &second) {
+        return peakSettingsChanged(first, second) && !(first.peakBypassed && second.peakBypassed);
+    }
 }
 
+bool lowCutSettingsChanged(const ChainSettings &a, const ChainSettings &b) {
+    return a.lowCutFreq != b.lowCutFreq
+           || a.lowCutSlope != b.lowCutSlope
+           || a.lowCutBypassed != b.lowCutBypassed;
+}
+
+bool peakSettingsChanged(const ChainSettings &a, const ChainSettings &b) {
+    return a.peakFreq != b.peakFreq
+           || a.peakGainInDecibels != b.peakGainInDecibels
+           || a.peakQuality != b.peakQuality
+           || a.peakBypassed != b.peakBypassed
+           || a.peakDynamic != b.peakDynamic;
+}
+
+bool highCutSettingsChanged(const ChainSettings &a, const ChainSettings &b) {
+    return a.highCutFreq != b.highCutFreq
+           || a.highCutSlope != b.highCutSlope
+           || a.highCutBypassed != b.highCutBypassed;
+}
+
+bool reverbSettingsChanged(const ChainSettings &a, const ChainSettings &b) {
+    return a.reverbRoomSize != b.reverbRoomSize
+           || a.reverbDamping != b.reverbDamping
+           || a.reverbWetLevel != b.reverbWetLevel
+           || a.reverbDryLevel != b.reverbDryLevel
+           || a.reverbWidth != b.reverbWidth
+           || a.reverbBypassed != b.reverbBypassed
+           || a.reverbFreezeMode != b.reverbFreezeMode
+           || a.reverbEngine != b.reverbEngine
+           || a.fdnHalfRate != b.fdnHalfRate;
+}
+
+bool switchesChains(const ChainSettings &a, const ChainSettings &b) {
+    auto sideSwitches = [](const ChainSettings &x, const ChainSettings &y) {
+        return x.lowCutBypassed != y.lowCutBypassed
+               || x.peakBypassed != y.peakBypassed
+               || x.highCutBypassed != y.highCutBypassed
+               || x.lowCutSlope != y.lowCutSlope
+               || x.highCutSlope != y.highCutSlope;
+    };
+    const auto bandSwitches = !std::equal(a.bands.begin(), a.bands.end(), b.bands.begin(), [](const auto &x, const auto &y) {
+        return x.active == y.active && (!x.active || x.type == y.type);
+    });
+
+    // a stereo mode change isn't one: it resets the chains instead
+    return a.filterTopology != b.filterTopology
+           || a.designMethod != b.designMethod
+           || sideSwitches(a, b)
+           || sideSwitches(getSecondSide(a), getSecondSide(b))
+           || bandSwitches;
+}
+
+void updateMonoChain(MonoChain &chain, const ChainSettings &chainSettings, double sampleRate) {
+    chain.setBypassed<ChainPositions::lowCut>(chainSettings.lowCutBypassed);
+    chain.setBypassed<ChainPositions::peak>(chainSettings.peakBypassed);
+    chain.setBypassed<ChainPositions::highCut>(chainSettings.highCutBypassed);
+
+    updatePeakFilter(chain.get<ChainPositions::peak>(), makePeakFilter(chainSettings, sampleRate));
+    updateCutFilter(chain.get<ChainPositions::lowCut>(), makeLowCutFilter(chainSettings, sampleRate),
+                    chainSettings.lowCutSlope);
+    updateCutFilter(chain.get<ChainPositions::highCut>(), makeHighCutFilter(chainSettings, sampleRate),
+                    chainSettings.highCutSlope);
+
+    for (int i = 0; i < numBands; ++i) {
+        const auto &band = chainSettings.bands[(size_t) i];
+        chain.get<ChainPositions::bands>().setBand(i, makeBandFilter(band, sampleRate, chainSettings.designMethod),
+                                                   band.active);
+    }
+}
+
+double getMagnitudeForFrequency(const MonoChain &chain, double frequency, double sampleRate) {
+    double magnitude = 1.0;
+
+    if (!chain.isBypassed<ChainPositions::lowCut>())
+        magnitude *= chain.get<ChainPositions::lowCut>().getMagnitudeForFrequency(frequency, sampleRate);
+
+    if (!chain.isBypassed<ChainPositions::peak>())
+        magnitude *= chain.get<ChainPositions::peak>().getMagnitudeForFrequency(frequency, sampleRate);
+
+    if (!chain.isBypassed<ChainPositions::highCut>())
+        magnitude *= chain.get<ChainPositions::highCut>().getMagnitudeForFrequency(frequency, sampleRate);
+
+    magnitude *= chain.get<ChainPositions::bands>().getMagnitudeForFrequency(frequency, sampleRate);
+
+    return magnitude;
+}
+
+bool isNeutral(const ChainSettings &chainSettings) {
+    auto sideNeutral = [](const ChainSettings &side) {
+        const auto peakNeutral = side.peakBypassed || (side.peakGainInDecibels == 0.0f && !side.peakDynamic);
+        const auto lowCutNeutral = side.lowCutBypassed
+                                   || side.lowCutFreq <= getDescriptor(Param::lowCutFreq).minimum;
+        const auto highCutNeutral = side.highCutBypassed
+                                    || side.highCutFreq >= getDescriptor(Param::highCutFreq).maximum;
+
+        return peakNeutral && lowCutNeutral && highCutNeutral;
+    };
+    const auto bandsNeutral = std::all_of(chainSettings.bands.begin(), chainSettings.bands.end(), [](const auto &band) {
+        const auto boosts = band.type == BandType::Peak || band.type == BandType::LowShelf
+                            || band.type == BandType::HighShelf;
+        return !band.active || (boosts && band.gainInDecibels == 0.0f);
+    });
+
+    return sideNeutral(chainSettings) && sideNeutral(getSecondSide(chainSettings)) && bandsNeutral
+           && chainSettings.reverbBypassed
+           && chainSettings.lfoTarget == LfoTarget::Off
+           && chainSettings.phaseMode == PhaseMode::Minimum
+           && !chainSettings.multirateBass
+           && !chainSettings.monoBass;
+}
+
+float evaluateLfoShape(LfoShape shape, float phase) {
+    using namespace juce;
+
+    switch (shape) {
+        case LfoShape::Triangle: return 1.0f - 2.0f * std::abs(phase) / MathConstants<float>::pi;
+        case LfoShape::Saw: return phase / MathConstants<float>::pi;
+        case LfoShape::Square: return phase < 0.0f ? -1.0f : 1.0f;
+        case LfoShape::Sine:
+        default: return std::sin(phase);
+    }
+}
+
+template<typename Math>
 void BassQualizerAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings) {
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+    if (chainSettings.designMethod == DesignMethod::Bilinear) {
+        const auto second = getSecondSide(chainSettings);
+        const auto numSides = peakSidesDiffer(chainSettings, second) ? 2 : 1;
+
+        for (int i = 0; i < numSides; ++i) {
+            const auto &side = i == 0 ? chainSettings : second;
+            peakPrototypes[(size_t) i] = PeakPrototype::at<Math>(getSampleRate(), side.peakFreq, side.peakQuality);
+            peakSvfCutoffs[(size_t) i] = prewarpSvfCutoff<Math>(getSampleRate(), side.peakFreq);
+        }
+    }
 
-    leftChain.setBypassed<ChainPositions::peak>(chainSettings.peakBypassed);
-    rightChain.setBypassed<ChainPositions::peak>(chainSettings.peakBypassed);
+    if (usesPeakDynamics(chainSettings))
+        peakDynamics.setBand<Math>(chainSettings.peakFreq, chainSettings.peakQuality);
 
-    updateCoefficients(leftChain.get<ChainPositions::peak>().coefficients, *peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::peak>().coefficients, *peakCoefficients);
+    updatePeakGain<Math>(chainSettings);
 }
 
-void updateCoefficients(Coefficients &old, const Coefficients &replacements) {
-    *old = *replacements;
+template<typename Math>
+void BassQualizerAudioProcessor::updatePeakGain(const ChainSettings &chainSettings) {
+    // the matched design moves its poles with the gain, so only the bilinear
+    // one can be redesigned from the cached terms
+    const auto bilinear = chainSettings.designMethod == DesignMethod::Bilinear;
+    const auto second = getSecondSide(chainSettings);
+    const auto split = peakSidesDiffer(chainSettings, second);
+
+    designedPeakDynamicGain = peakDynamicGain;
+
+    auto designSvf = [&](size_t index, const ChainSettings &side) {
+        const auto gainFactor = juce::Decibels::decibelsToGain((double) side.peakGainInDecibels);
+        return bilinear
+                   ? makeSvfPeakAtCutoff(peakSvfCutoffs[index], side.peakQuality, gainFactor)
+                   : makePeakFilterSvf<Math>(side, getSampleRate());
+    };
+
+    auto designBiquad = [&](size_t index, const ChainSettings &side) {
+        const auto gainFactor = juce::Decibels::decibelsToGain((double) side.peakGainInDecibels);
+        return bilinear
+                   ? peakPrototypes[index].getCoefficients(gainFactor)
+                   : makePeakFilter<Math>(side, getSampleRate());
+    };
+
+    // only the chains of the selected topology and precision are kept up to date
+    forActiveGroups([&](auto &groups) {
+        if (chainSettings.filterTopology == FilterTopology::StateVariable) {
+            if (split)
+                updatePeakFilters<ChainPositions::peak>(groups.svfChains,
+                                                        designSvf(0, chainSettings), chainSettings.peakBypassed,
+                                                        designSvf(1, second), second.peakBypassed);
+            else
+                updatePeakFilters<ChainPositions::peak>(groups.svfChains, designSvf(0, chainSettings),
+                                                        chainSettings.peakBypassed);
+        } else {
+            if (split)
+                updatePeakFilters<ChainPositions::peak>(groups.chains,
+                                                        designBiquad(0, chainSettings), chainSettings.peakBypassed,
+                                                        designBiquad(1, second), second.peakBypassed);
+            else
+                updatePeakFilters<ChainPositions::peak>(groups.chains, designBiquad(0, chainSettings),
+                                                        chainSettings.peakBypassed);
+        }
+    });
 }
 
-void BassQualizerAudioProcessor::updateLowCutFilter(const ChainSettings &chainSettings) {
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    auto &leftLowCut = leftChain.get<ChainPositions::lowCut>();
-    auto &rightLowCut = rightChain.get<ChainPositions::lowCut>();
+bool BassQualizerAudioProcessor::usesPeakDynamics(const ChainSettings &chainSettings) {
+    return chainSettings.peakDynamic
+           && !chainSettings.peakBypassed
+           && chainSettings.phaseMode == PhaseMode::Minimum;
+}
+
+bool BassQualizerAudioProcessor::usesMultirateBands() const {
+    return lastChainSettings.multirateBass && floatGroups.multirateBands[0].getFactor() > 1;
+}
 
-    leftChain.setBypassed<ChainPositions::lowCut>(chainSettings.lowCutBypassed);
-    rightChain.setBypassed<ChainPositions::lowCut>(chainSettings.lowCutBypassed);
+bool BassQualizerAudioProcessor::shouldRunLowCutMultirate(const ChainSettings &chainSettings) const {
+    const auto factor = floatGroups.multirateBands[0].getFactor();
+    const auto second = getSecondSide(chainSettings);
 
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+    // the low band is accurate up to about a quarter of its own Nyquist; each
+    // side that uses the low cut has to fit
+    auto fits = [&](const ChainSettings &side) {
+        return side.lowCutBypassed || side.lowCutFreq <= getSampleRate() / factor / 8.0;
+    };
+
+    return chainSettings.multirateBass
+           && factor > 1
+           && !(chainSettings.lowCutBypassed && second.lowCutBypassed)
+           && fits(chainSettings) && fits(second);
 }
 
+template<typename Math>
+void BassQualizerAudioProcessor::updateLowCutFilter(const ChainSettings &chainSettings) {
+    const auto second = getSecondSide(chainSettings);
+    const auto split = lowCutSidesDiffer(chainSettings, second);
+    const auto firstStages = getNumCutStages(chainSettings.lowCutSlope, chainSettings.lowCutBypassed);
+    const auto secondStages = getNumCutStages(second.lowCutSlope, second.lowCutBypassed);
+
+    forActiveGroups([&](auto &groups) {
+        for (auto &band: groups.multirateBands)
+            band.setActive(lowCutMultirate);
+
+        if (lowCutMultirate) {
+            // modulation can push the frequency past the low band's range
+            const auto lowRate = getSampleRate() / groups.multirateBands[0].getFactor();
+            auto designLowRate = [&](ChainSettings lowRateSettings) {
+                lowRateSettings.lowCutFreq = juce::jmin(lowRateSettings.lowCutFreq, (float) (0.45 * lowRate));
+                return makeLowCutFilterSvf<Math>(lowRateSettings, lowRate);
+            };
+
+            const auto coefficients = designLowRate(chainSettings);
+
+            if (split) {
+                const auto secondCoefficients = designLowRate(second);
+                for (auto &band: groups.multirateBands)
+                    updateCutFilter(band.getCascade(), coefficients, firstStages, secondCoefficients, secondStages);
+            } else {
+                for (auto &band: groups.multirateBands)
+                    updateCutFilter(band.getCascade(), coefficients, chainSettings.lowCutSlope);
+            }
+
+            for (auto &chain: groups.chains)
+                chain.template setBypassed<ChainPositions::lowCut>(true);
+
+            for (auto &chain: groups.svfChains)
+                chain.template setBypassed<ChainPositions::lowCut>(true);
+
+            return;
+        }
+
+        const auto stateVariable = chainSettings.filterTopology == FilterTopology::StateVariable;
+
+        if (stateVariable && split)
+            updateCutFilters<ChainPositions::lowCut>(groups.svfChains,
+                                                     makeLowCutFilterSvf<Math>(chainSettings, getSampleRate()),
+                                                     firstStages,
+                                                     makeLowCutFilterSvf<Math>(second, getSampleRate()),
+                                                     secondStages);
+        else if (stateVariable)
+            updateCutFilters<ChainPositions::lowCut>(groups.svfChains,
+                                                     makeLowCutFilterSvf<Math>(chainSettings, getSampleRate()),
+                                                     chainSettings.lowCutSlope,
+                                                     chainSettings.lowCutBypassed);
+        else if (split)
+            updateCutFilters<ChainPositions::lowCut>(groups.chains,
+                                                     makeLowCutFilter<Math>(chainSettings, getSampleRate()),
+                                                     firstStages,
+                                                     makeLowCutFilter<Math>(second, getSampleRate()),
+                                                     secondStages);
+        else
+            updateCutFilters<ChainPositions::lowCut>(groups.chains,
+                                                     makeLowCutFilter<Math>(chainSettings, getSampleRate()),
+                                                     chainSettings.lowCutSlope,
+                                                     chainSettings.lowCutBypassed);
+    });
+}
+
+template<typename Math>
 void BassQualizerAudioProcessor::updateHighCutFilter(const ChainSettings &chainSettings) {
-    auto highCutCoefficientsHigh = makeHighCutFilter(chainSettings, getSampleRate());
-    auto &leftHighCut = leftChain.get<ChainPositions::highCut>();
-    auto &rightHighCut = rightChain.get<ChainPositions::highCut>();
+    const auto second = getSecondSide(chainSettings);
+    const auto split = highCutSidesDiffer(chainSettings, second);
+    const auto firstStages = getNumCutStages(chainSettings.highCutSlope, chainSettings.highCutBypassed);
+    const auto secondStages = getNumCutStages(second.highCutSlope, second.highCutBypassed);
+
+    forActiveGroups([&](auto &groups) {
+        const auto stateVariable = chainSettings.filterTopology == FilterTopology::StateVariable;
+
+        if (stateVariable && split)
+            updateCutFilters<ChainPositions::highCut>(groups.svfChains,
+                                                      makeHighCutFilterSvf<Math>(chainSettings, getSampleRate()),
+                                                      firstStages,
+                                                      makeHighCutFilterSvf<Math>(second, getSampleRate()),
+                                                      secondStages);
+        else if (stateVariable)
+            updateCutFilters<ChainPositions::highCut>(groups.svfChains,
+                                                      makeHighCutFilterSvf<Math>(chainSettings, getSampleRate()),
+                                                      chainSettings.highCutSlope,
+                                                      chainSettings.highCutBypassed);
+        else if (split)
+            updateCutFilters<ChainPositions::highCut>(groups.chains,
+                                                      makeHighCutFilter<Math>(chainSettings, getSampleRate()),
+                                                      firstStages,
+                                                      makeHighCutFilter<Math>(second, getSampleRate()),
+                                                      secondStages);
+        else
+            updateCutFilters<ChainPositions::highCut>(groups.chains,
+                                                      makeHighCutFilter<Math>(chainSettings, getSampleRate()),
+                                                      chainSettings.highCutSlope,
+                                                      chainSettings.highCutBypassed);
+    });
+}
+
+template<typename Math>
+void BassQualizerAudioProcessor::updateBand(int band, const ChainSettings &chainSettings) {
+    const auto &settings = chainSettings.bands[(size_t) band];
+    const auto coefficients = makeBandFilter<Math>(settings, getSampleRate(), chainSettings.designMethod);
+
+    forActiveGroups([&](auto &groups) {
+        auto setBand = [&](auto &chains) {
+            for (auto &chain: chains)
+                chain.template get<ChainPositions::bands>().setBand(band, coefficients, settings.active);
+        };
+
+        if (chainSettings.filterTopology == FilterTopology::StateVariable)
+            setBand(groups.svfChains);
+        else
+            setBand(groups.chains);
+    });
+}
 
-    leftChain.setBypassed<ChainPositions::highCut>(chainSettings.highCutBypassed);
-    rightChain.setBypassed<ChainPositions::highCut>(chainSettings.highCutBypassed);
+template<typename Math>
+void BassQualizerAudioProcessor::updateMonoBass(const ChainSettings &chainSettings) {
+    const auto frequency = juce::jmin((double) chainSettings.monoBassFreq, 0.45 * getSampleRate());
 
-    updateCutFilter(leftHighCut, highCutCoefficientsHigh, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficientsHigh, chainSettings.highCutSlope);
+    forActiveGroups([&](auto &groups) {
+        for (auto &monoMaker: groups.monoMakers)
+            monoMaker.template setCrossover<Math>(getSampleRate(), frequency);
+    });
 }
 
 void BassQualizerAudioProcessor::updateReverbFilter(const ChainSettings &chainSettings) {
@@ -281,61 +1269,386 @@ void BassQualizerAudioProcessor::updateReverbFilter(const ChainSettings &chainSe
     reverbParams.width = chainSettings.reverbWidth;
     reverbParams.freezeMode = chainSettings.reverbFreezeMode;
 
-    reverb.setParameters(reverbParams);
-    reverb.setEnabled(!chainSettings.reverbBypassed);
+    for (auto &reverb: reverbs)
+        reverb.setParameters(reverbParams);
+
+    forEachFdnReverb([&](auto &reverb) {
+        reverb.setParameters(reverbParams);
+        reverb.setHalfRate(chainSettings.fdnHalfRate);
+    });
+
+    convolutionReverb->setLevels(chainSettings.reverbWetLevel * reverbWetScale,
+                                 chainSettings.reverbDryLevel * reverbDryScale);
 }
 
 
 void BassQualizerAudioProcessor::updateFilters() {
-    auto chainSettings = getChainSettings(apvts);
+    // Only the bands whose own parameters moved are redesigned. The designs
+    // are value types, so nothing here allocates.
+    auto chainSettings = getChainSettings(parameterHandles);
+
+    // a switch while a fade is still running inside the held chains waits
+    // for it, at most switchFadeSeconds; this runs every block
+    if (heldFadeRemaining > 0 && (stateLoaded || switchesChains(chainSettings, lastChainSettings)))
+        return;
+
+    const auto topologyChanged = chainSettings.filterTopology != lastChainSettings.filterTopology;
+    const auto lfoTargetChanged = chainSettings.lfoTarget != lastChainSettings.lfoTarget;
+    const auto phaseModeChanged = chainSettings.phaseMode != lastChainSettings.phaseMode;
+    const auto designMethodChanged = chainSettings.designMethod != lastChainSettings.designMethod;
+    const auto multirateChanged = chainSettings.multirateBass != lastChainSettings.multirateBass;
+    const auto stereoModeChanged = chainSettings.stereoMode != lastChainSettings.stereoMode;
+    const auto force = forceFilterUpdate.exchange(false) || topologyChanged || lfoTargetChanged || phaseModeChanged
+                       || designMethodChanged || multirateChanged || stereoModeChanged;
+
+    // before anything below resets or redesigns the chains; the linear phase
+    // EQ crossfades its own kernels
+    const auto switched = stateLoaded.exchange(false) || switchesChains(chainSettings, lastChainSettings);
+
+    if (phaseModeChanged || stereoModeChanged) {
+        // the held chains belong to the other mode, or hold the lanes in the
+        // other stereo encoding; the new mode starts from silence
+        cancelSwitchFade();
+        forActiveGroups([](auto &groups) { groups.resetChains(); });
+    } else {
+        if (switched && chainSettings.phaseMode == PhaseMode::Minimum)
+            beginSwitchFade();
+
+        // the chains of the other topology have been idle, start them from silence
+        if (topologyChanged)
+            forActiveGroups([&chainSettings](auto &groups) { groups.resetChains(chainSettings.filterTopology); });
+    }
+
+    if (phaseModeChanged)
+        linearPhaseEQ->reset();
+
+    if (phaseModeChanged || multirateChanged || stereoModeChanged)
+        forActiveGroups([](auto &groups) { groups.resetMultirateBands(); });
+
+    // auto gain starts over from unity each time it is switched on
+    if (chainSettings.autoGain != lastChainSettings.autoGain) {
+        loudnessMatch.reset();
+        autoGainSmoother.setCurrentAndTargetValue(1.0f);
+    }
+
+    // the crossover has been idle while mono bass was off
+    if (chainSettings.monoBass && !lastChainSettings.monoBass)
+        forActiveGroups([](auto &groups) {
+            for (auto &monoMaker: groups.monoMakers)
+                monoMaker.reset();
+        });
+
+    lowCutMultirate = shouldRunLowCutMultirate(chainSettings);
+
+    if (!usesPeakDynamics(chainSettings))
+        peakDynamicGain = 0.0f;
+    else if (!usesPeakDynamics(lastChainSettings))
+        peakDynamics.reset();
+
+    if (force || chainSettings.peakThreshold != lastChainSettings.peakThreshold
+        || chainSettings.peakRatio != lastChainSettings.peakRatio
+        || chainSettings.peakAttack != lastChainSettings.peakAttack
+        || chainSettings.peakRelease != lastChainSettings.peakRelease)
+        peakDynamics.setDynamics(chainSettings.peakThreshold, chainSettings.peakRatio,
+                                 chainSettings.peakAttack, chainSettings.peakRelease);
+
+    setSmootherTargets(chainSettings, force);
+    const auto smoothedSettings = getSmoothedSettings(chainSettings);
+
+    const auto second = getSecondSide(chainSettings);
+    const auto lastSecond = getSecondSide(lastChainSettings);
+    const auto peakChanged = force || peakSettingsChanged(chainSettings, lastChainSettings)
+                             || peakSettingsChanged(second, lastSecond);
+    const auto lowCutChanged = force || lowCutSettingsChanged(chainSettings, lastChainSettings)
+                               || lowCutSettingsChanged(second, lastSecond);
+    const auto highCutChanged = force || highCutSettingsChanged(chainSettings, lastChainSettings)
+                                || highCutSettingsChanged(second, lastSecond);
+
+    if (peakChanged)
+        updatePeakFilter(smoothedSettings);
+
+    if (lowCutChanged)
+        updateLowCutFilter(smoothedSettings);
+
+    if (highCutChanged)
+        updateHighCutFilter(smoothedSettings);
+
+    auto bandsChanged = false;
+
+    for (int i = 0; i < numBands; ++i) {
+        if (force || chainSettings.bands[(size_t) i] != lastChainSettings.bands[(size_t) i]) {
+            updateBand(i, smoothedSettings);
+            bandsChanged = true;
+        }
+    }
+
+    if (force || chainSettings.monoBass != lastChainSettings.monoBass
+        || chainSettings.monoBassFreq != lastChainSettings.monoBassFreq)
+        updateMonoBass(smoothedSettings);
+
+    // the linear phase kernel follows the parameter targets, its own
+    // crossfade takes the place of the smoothing
+    linearPhaseUpdatePending = linearPhaseUpdatePending || peakChanged || lowCutChanged || highCutChanged
+                               || bandsChanged;
+
+    if (linearPhaseUpdatePending && chainSettings.phaseMode == PhaseMode::Linear) {
+        linearPhaseUpdatePending = !linearPhaseEQ->setChainSettings(chainSettings);
+
+        if (!linearPhaseUpdatePending)
+            triggerAsyncUpdate();
+    }
+
+    if (force || reverbSettingsChanged(chainSettings, lastChainSettings))
+        updateReverbFilter(chainSettings);
+
+    // the engine switched to has been idle, start it from silence
+    if (chainSettings.reverbEngine != lastChainSettings.reverbEngine)
+        reverbSkipped = true;
+
+    lastChainSettings = chainSettings;
+
+    if (force)
+        updateLatency();
 
-    updatePeakFilter(chainSettings);
-    updateLowCutFilter(chainSettings);
-    updateHighCutFilter(chainSettings);
-    updateReverbFilter(chainSettings);
+    neutral = isNeutral(chainSettings);
+    tailLengthSeconds = computeTailLengthSeconds(chainSettings);
 }
 
+void BassQualizerAudioProcessor::updateLatency() {
+    auto latency = 0;
+
+    if (lastChainSettings.phaseMode == PhaseMode::Linear)
+        latency = linearPhaseEQ->getLatencySamples();
+    else if (usesMultirateBands())
+        latency = floatGroups.multirateBands[0].getLatencySamples();
+
+    if (pendingLatency.exchange(latency) != latency)
+        triggerAsyncUpdate();
+}
+
+void BassQualizerAudioProcessor::handleAsyncUpdate() {
+    setLatencySamples(pendingLatency);
+    linearPhaseEQ->wakeDesigner();
+}
+
+
+void BassQualizerAudioProcessor::SideSmoothers::reset(double sampleRate, double rampLengthInSeconds) {
+    for (auto *smoother: {&lowCutFreq, &highCutFreq, &peakFreq, &peakQuality})
+        smoother->reset(sampleRate, rampLengthInSeconds);
+
+    peakGain.reset(sampleRate, rampLengthInSeconds);
+}
+
+void BassQualizerAudioProcessor::SideSmoothers::setTargets(const ChainSettings &side, bool jumpToTarget) {
+    if (jumpToTarget) {
+        lowCutFreq.setCurrentAndTargetValue(side.lowCutFreq);
+        highCutFreq.setCurrentAndTargetValue(side.highCutFreq);
+        peakFreq.setCurrentAndTargetValue(side.peakFreq);
+        peakQuality.setCurrentAndTargetValue(side.peakQuality);
+        peakGain.setCurrentAndTargetValue(side.peakGainInDecibels);
+        return;
+    }
+
+    lowCutFreq.setTargetValue(side.lowCutFreq);
+    highCutFreq.setTargetValue(side.highCutFreq);
+    peakFreq.setTargetValue(side.peakFreq);
+    peakQuality.setTargetValue(side.peakQuality);
+    peakGain.setTargetValue(side.peakGainInDecibels);
+}
+
+void BassQualizerAudioProcessor::SideSmoothers::skipCuts(int numSamples) {
+    lowCutFreq.skip(numSamples);
+    highCutFreq.skip(numSamples);
+}
+
+void BassQualizerAudioProcessor::SideSmoothers::skipPeak(int numSamples) {
+    peakFreq.skip(numSamples);
+    peakQuality.skip(numSamples);
+    peakGain.skip(numSamples);
+}
+
+bool BassQualizerAudioProcessor::SideSmoothers::isPeakSmoothing() const {
+    return peakFreq.isSmoothing() || peakQuality.isSmoothing() || peakGain.isSmoothing();
+}
+
+bool BassQualizerAudioProcessor::SideSmoothers::isSmoothing() const {
+    return lowCutFreq.isSmoothing() || highCutFreq.isSmoothing() || isPeakSmoothing();
+}
+
+void BassQualizerAudioProcessor::setSmootherTargets(const ChainSettings &chainSettings, bool jumpToTarget) {
+    sideSmoothers[0].setTargets(chainSettings, jumpToTarget);
+    sideSmoothers[1].setTargets(getSecondSide(chainSettings), jumpToTarget);
+
+    for (size_t i = 0; i < (size_t) numBands; ++i) {
+        const auto &band = chainSettings.bands[i];
+        const auto &lastBand = lastChainSettings.bands[i];
+        auto &smoothers = bandSmoothers[i];
+
+        // a band that is off, has just been switched on or changed type has
+        // nothing to ramp from
+        if (jumpToTarget || !band.active || !lastBand.active || band.type != lastBand.type) {
+            smoothers.freq.setCurrentAndTargetValue(band.freq);
+            smoothers.quality.setCurrentAndTargetValue(band.quality);
+            smoothers.gain.setCurrentAndTargetValue(band.gainInDecibels);
+        } else {
+            smoothers.freq.setTargetValue(band.freq);
+            smoothers.quality.setTargetValue(band.quality);
+            smoothers.gain.setTargetValue(band.gainInDecibels);
+        }
+    }
+
+    if (jumpToTarget || !chainSettings.monoBass || !lastChainSettings.monoBass)
+        monoBassFreqSmoother.setCurrentAndTargetValue(chainSettings.monoBassFreq);
+    else
+        monoBassFreqSmoother.setTargetValue(chainSettings.monoBassFreq);
+}
+
+ChainSettings BassQualizerAudioProcessor::getSmoothedSettings(ChainSettings chainSettings) const {
+    const auto &first = sideSmoothers[0];
+    chainSettings.lowCutFreq = first.lowCutFreq.getCurrentValue();
+    chainSettings.highCutFreq = first.highCutFreq.getCurrentValue();
+    chainSettings.peakFreq = first.peakFreq.getCurrentValue();
+    chainSettings.peakQuality = first.peakQuality.getCurrentValue();
+    chainSettings.peakGainInDecibels = first.peakGain.getCurrentValue() + peakDynamicGain;
+
+    // only read back by getSecondSide when the stereo mode isn't linked
+    const auto &second = sideSmoothers[1];
+    chainSettings.second.lowCutFreq = second.lowCutFreq.getCurrentValue();
+    chainSettings.second.highCutFreq = second.highCutFreq.getCurrentValue();
+    chainSettings.second.peakFreq = second.peakFreq.getCurrentValue();
+    chainSettings.second.peakQuality = second.peakQuality.getCurrentValue();
+    chainSettings.second.peakGainInDecibels = second.peakGain.getCurrentValue() + peakDynamicGain;
+
+    for (size_t i = 0; i < (size_t) numBands; ++i) {
+        chainSettings.bands[i].freq = bandSmoothers[i].freq.getCurrentValue();
+        chainSettings.bands[i].quality = bandSmoothers[i].quality.getCurrentValue();
+        chainSettings.bands[i].gainInDecibels = bandSmoothers[i].gain.getCurrentValue();
+    }
+
+    chainSettings.monoBassFreq = monoBassFreqSmoother.getCurrentValue();
+
+    applyModulation(chainSettings);
+
+    return chainSettings;
+}
+
+void BassQualizerAudioProcessor::advanceLfo(int numSamples) {
+    osc.setFrequency(lastChainSettings.lfoRate);
+
+    for (int i = 0; i < numSamples; i += audioRateBlockSize)
+        lfoValue = osc.processSample(0.0f);
+}
+
+void BassQualizerAudioProcessor::applyModulation(ChainSettings &chainSettings) const {
+    if (chainSettings.lfoTarget == LfoTarget::Off)
+        return;
+
+    const auto ratio = std::exp2(chainSettings.lfoDepth * lfoValue);
+    const auto maxFrequency = 0.45f * (float) getSampleRate();
+    auto modulate = [ratio, maxFrequency](float frequency) {
+        return juce::jlimit(20.0f, maxFrequency, frequency * ratio);
+    };
+
+    // both sides follow the LFO
+    switch (chainSettings.lfoTarget) {
+        case LfoTarget::PeakFreq: chainSettings.peakFreq = modulate(chainSettings.peakFreq);
+            chainSettings.second.peakFreq = modulate(chainSettings.second.peakFreq);
+            break;
+        case LfoTarget::LowCutFreq: chainSettings.lowCutFreq = modulate(chainSettings.lowCutFreq);
+            chainSettings.second.lowCutFreq = modulate(chainSettings.second.lowCutFreq);
+            break;
+        case LfoTarget::HighCutFreq: chainSettings.highCutFreq = modulate(chainSettings.highCutFreq);
+            chainSettings.second.highCutFreq = modulate(chainSettings.second.highCutFreq);
+            break;
+        case LfoTarget::Off:
+        default: break;
+    }
+}
+
+void BassQualizerAudioProcessor::updateSmoothedFilters(int numSamples) {
+    const auto lfoTarget = lastChainSettings.lfoTarget;
+
+    if (lfoTarget != LfoTarget::Off)
+        advanceLfo(numSamples);
+
+    const auto &first = sideSmoothers[0], &second = sideSmoothers[1];
+    const auto lowCutRamping = first.lowCutFreq.isSmoothing() || second.lowCutFreq.isSmoothing();
+    const auto highCutRamping = first.highCutFreq.isSmoothing() || second.highCutFreq.isSmoothing();
+    const auto lowCutMoving = lowCutRamping || lfoTarget == LfoTarget::LowCutFreq;
+    const auto highCutMoving = highCutRamping || lfoTarget == LfoTarget::HighCutFreq;
+    const auto peakMoving = first.isPeakSmoothing() || second.isPeakSmoothing() || lfoTarget == LfoTarget::PeakFreq;
+    const auto peakGainMoving = std::abs(peakDynamicGain - designedPeakDynamicGain) > 0.01f;
+
+    std::array<bool, numBands> bandMoving{};
+    for (size_t i = 0; i < (size_t) numBands; ++i)
+        bandMoving[i] = bandSmoothers[i].freq.isSmoothing()
+                        || bandSmoothers[i].quality.isSmoothing()
+                        || bandSmoothers[i].gain.isSmoothing();
+
+    const auto anyBandMoving = std::find(bandMoving.begin(), bandMoving.end(), true) != bandMoving.end();
+    const auto monoBassMoving = monoBassFreqSmoother.isSmoothing();
+
+    // a cut that starts ramping is redesigned on its first tick
+    if (!lowCutRamping && !highCutRamping) {
+        cutTicksUntilRedesign = 0;
+        cutSamplesPending = 0;
+    }
+
+    // the static path: nothing is ramping, so nothing gets redesigned
+    if (!lowCutMoving && !highCutMoving && !peakMoving && !peakGainMoving && !anyBandMoving && !monoBassMoving)
+        return;
+
+    // a ramping cut catches up with its ramp and is redesigned every
+    // cutRedesignTicks ticks; the LFO still moves it every tick
+    cutSamplesPending += numSamples;
+
+    const auto cutTick = --cutTicksUntilRedesign <= 0
+                         || lfoTarget == LfoTarget::LowCutFreq || lfoTarget == LfoTarget::HighCutFreq;
+    if (cutTick) {
+        cutTicksUntilRedesign = cutRedesignTicks;
+
+        for (auto &smoothers: sideSmoothers)
+            smoothers.skipCuts(cutSamplesPending);
+
+        cutSamplesPending = 0;
+    }
+
+    for (auto &smoothers: sideSmoothers)
+        smoothers.skipPeak(numSamples);
+
+    for (auto &smoothers: bandSmoothers) {
+        smoothers.freq.skip(numSamples);
+        smoothers.quality.skip(numSamples);
+        smoothers.gain.skip(numSamples);
+    }
+
+    monoBassFreqSmoother.skip(numSamples);
+
+    const auto smoothedSettings = getSmoothedSettings(lastChainSettings);
+
+    // these redesigns can happen every few samples, so they use the
+    // approximated trigonometry
+    if (lowCutMoving && cutTick)
+        updateLowCutFilter<FastMath>(smoothedSettings);
+
+    if (highCutMoving && cutTick)
+        updateHighCutFilter<FastMath>(smoothedSettings);
+
+    if (peakMoving)
+        updatePeakFilter<FastMath>(smoothedSettings);
+    else if (peakGainMoving)
+        updatePeakGain<FastMath>(smoothedSettings);
+
+    for (int i = 0; i < numBands; ++i)
+        if (bandMoving[(size_t) i])
+            updateBand<FastMath>(i, smoothedSettings);
+
+    if (monoBassMoving)
+        updateMonoBass<FastMath>(smoothedSettings);
+}
 
 juce::AudioProcessorValueTreeState::ParameterLayout BassQualizerAudioProcessor::createParameters() {
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-
-    layout.add(std::make_unique<juce::AudioParameterFloat>("lowCutFreq", "Low Cut Freq",
-                                                           juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f),
-                                                           20.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("highCutFreq", "High Cut Freq",
-                                                           juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f),
-                                                           20000.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("peakFreq", "Peak Freq",
-                                                           juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f),
-                                                           750.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("peakGainInDb", "Peak Gain", -24.0f, 24.0f, 0.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("peakQuality", "Peak Quality", 0.1f, 10.0f, 1.0f));
-
-    juce::StringArray stringArray;
-    for (int i = 0; i < 4; ++i) {
-        juce::String str;
-        str << (12 + i * 12);
-        str << " db/Oct";
-        stringArray.add(str);
-    }
-
-    layout.add(std::make_unique<juce::AudioParameterChoice>("lowCutSlope", "Low Cut Slope", stringArray, 0));
-    layout.add(std::make_unique<juce::AudioParameterChoice>("highCutSlope", "High Cut Slope", stringArray, 0));
-
-    layout.add(std::make_unique<juce::AudioParameterBool>("lowCutBypass", "Low Cut Bypass", false));
-    layout.add(std::make_unique<juce::AudioParameterBool>("peakBypass", "Peak Bypass", false));
-    layout.add(std::make_unique<juce::AudioParameterBool>("highCutBypass", "High Cut Bypass", false));
-
-    layout.add(std::make_unique<juce::AudioParameterFloat>("reverbRoomSize", "Room Size", 0.0f, 1.0f, 0.5f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("reverbDamping", "Damping", 0.0f, 1.0f, 0.5f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("reverbWetLevel", "Wet Level", 0.0f, 1.0f, 0.33f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("reverbDryLevel", "Dry Level", 0.0f, 1.0f, 0.4f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("reverbWidth", "Width", 0.0f, 1.0f, 1.0f));
-    layout.add(std::make_unique<juce::AudioParameterBool>("reverbFreezeMode", "Freeze Mode", false));
-
-    layout.add(std::make_unique<juce::AudioParameterBool>("reverbBypass", "Reverb Bypass", true));
-
-    return layout;
+    return createParameterLayout();
 }
 
 //==============================================================================
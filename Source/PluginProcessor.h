@@ -9,132 +9,116 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "BiquadCascade.h"
+#include "SvfCascade.h"
+#include "MultirateBand.h"
+#include "MonoMaker.h"
+#include "FdnReverb.h"
+#include "PeakDynamics.h"
+#include "BandBank.h"
+#include "LoudnessMatch.h"
+#include "LevelMeter.h"
+#include "SampleRing.h"
+#include "Parameters.h"
 
-template<typename T>
-struct Fifo {
-    void prepare(int numChannels, int numSamples) {
-        static_assert(std::is_same_v<T, juce::AudioBuffer<float> >,
-                      "prepare(numChannels, numSamples) should only be used when the Fifo is holding juce::AudioBuffer<float>")
-                ;
-        for (auto &buffer: buffers) {
-            buffer.setSize(numChannels,
-                           numSamples,
-                           false, //clear everything?
-                           true, //including the extra space?
-                           true); //avoid reallocating if you can?
-            buffer.clear();
-        }
-    }
-
-    void prepare(size_t numElements) {
-        static_assert(std::is_same_v<T, std::vector<float> >,
-                      "prepare(numElements) should only be used when the Fifo is holding std::vector<float>");
-        for (auto &buffer: buffers) {
-            buffer.clear();
-            buffer.resize(numElements, 0);
-        }
-    }
-
-    bool push(const T &t) {
-        auto write = fifo.write(1);
-        if (write.blockSize1 > 0) {
-            buffers[write.startIndex1] = t;
-            return true;
-        }
+enum Channel {
+    Right, Left
+};
 
-        return false;
-    }
+enum Slope {
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48
+};
 
-    bool pull(T &t) {
-        auto read = fifo.read(1);
-        if (read.blockSize1 > 0) {
-            t = buffers[read.startIndex1];
-            return true;
-        }
+enum class FilterTopology {
+    Biquad,
+    StateVariable
+};
 
-        return false;
-    }
+enum class LfoShape {
+    Sine,
+    Triangle,
+    Saw,
+    Square
+};
 
-    int getNumAvailableForReading() const {
-        return fifo.getNumReady();
-    }
+enum class LfoTarget {
+    Off,
+    PeakFreq,
+    LowCutFreq,
+    HighCutFreq
+};
 
-private:
-    static constexpr int Capacity = 30;
-    std::array<T, Capacity> buffers;
-    juce::AbstractFifo fifo{Capacity};
+enum class PhaseMode {
+    Minimum,
+    Linear
 };
 
+/**
+ How analog prototypes become biquads: the bilinear transform (cramps near
+ Nyquist) or magnitude matching (keeps the analog shape up to Nyquist).
+ */
+enum class DesignMethod {
+    Bilinear,
+    Matched
+};
 
-enum Channel {
-    Right, Left
+/**
+ How the two channels of each pair are filtered: with the same settings, or
+ the second settings set applied to the right channel, or to the side
+ signal after mid/side encoding.
+ */
+enum class StereoMode {
+    Linked,
+    LeftRight,
+    MidSide
 };
 
-template<typename BlockType>
-struct SingleChannelSampleFifo {
-    SingleChannelSampleFifo(Channel ch) : channelToUse(ch) {
-        prepared.set(false);
-    }
+enum class ReverbEngine {
+    Algorithmic,
+    Convolution,
+    Fdn
+};
 
-    void update(const BlockType &buffer) {
-        jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse);
-        auto *channelPtr = buffer.getReadPointer(channelToUse);
+/** Order as in bandTypeChoices. */
+enum class BandType {
+    Peak,
+    LowShelf,
+    HighShelf,
+    Notch,
+    LowCut,
+    HighCut
+};
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i) {
-            pushNextSampleIntoFifo(channelPtr[i]);
-        }
-    }
+struct BandSettings {
+    bool active{false};
+    BandType type{BandType::Peak};
+    float freq{1000.0f}, gainInDecibels{0.0f}, quality{1.0f};
 
-    void prepare(int bufferSize) {
-        prepared.set(false);
-        size.set(bufferSize);
-
-        bufferToFill.setSize(1, //channel
-                             bufferSize, //num samples
-                             false, //keepExistingContent
-                             true, //clear extra space
-                             true); //avoid reallocating
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
-        prepared.set(true);
+    bool operator!=(const BandSettings &other) const {
+        return active != other.active || type != other.type || freq != other.freq
+               || gainInDecibels != other.gainInDecibels || quality != other.quality;
     }
+};
 
-    //==============================================================================
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
-    bool isPrepared() const { return prepared.get(); }
-    int getSize() const { return size.get(); }
-    //==============================================================================
-    bool getAudioBuffer(BlockType &buf) { return audioBufferFifo.pull(buf); }
-
-private:
-    Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
-    juce::Atomic<bool> prepared = false;
-    juce::Atomic<int> size = 0;
-
-    void pushNextSampleIntoFifo(float sample) {
-        if (fifoIndex == bufferToFill.getNumSamples()) {
-            auto ok = audioBufferFifo.push(bufferToFill);
-
-            juce::ignoreUnused(ok);
+/** The cut and peak settings of the second channel of each pair. */
+struct SecondSideSettings {
+    float peakFreq{0},
+            peakGainInDecibels{0},
+            peakQuality{1.f},
+            lowCutFreq{0}, highCutFreq{0};
 
-            fifoIndex = 0;
-        }
+    Slope lowCutSlope{Slope::Slope_12}, highCutSlope{Slope::Slope_12};
 
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
-    }
+    bool lowCutBypassed{false},
+            peakBypassed{false},
+            highCutBypassed{false};
 };
 
-enum Slope {
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
-};
+/** The LFO waveform at a phase in [-pi, pi), as handed out by juce::dsp::Oscillator. */
+float evaluateLfoShape(LfoShape shape, float phase);
 
 struct ChainSettings {
     float peakFreq{0},
@@ -149,6 +133,35 @@ struct ChainSettings {
 
     Slope lowCutSlope{Slope::Slope_12}, highCutSlope{Slope::Slope_12};
 
+    FilterTopology filterTopology{FilterTopology::Biquad};
+
+    float lfoRate{1.0f}, lfoDepth{1.0f};
+    LfoShape lfoShape{LfoShape::Sine};
+    LfoTarget lfoTarget{LfoTarget::Off};
+    bool lfoAudioRate{false};
+
+    PhaseMode phaseMode{PhaseMode::Minimum};
+
+    DesignMethod designMethod{DesignMethod::Bilinear};
+
+    bool multirateBass{false};
+
+    ReverbEngine reverbEngine{ReverbEngine::Algorithmic};
+    bool fdnHalfRate{false};
+
+    bool peakDynamic{false}, peakSidechain{false};
+    float peakThreshold{-24.0f}, peakRatio{4.0f}, peakAttack{10.0f}, peakRelease{100.0f};
+
+    std::array<BandSettings, numBands> bands;
+
+    StereoMode stereoMode{StereoMode::Linked};
+    SecondSideSettings second;
+
+    bool monoBass{false};
+    float monoBassFreq{120.0f};
+
+    bool autoGain{false}, autoGainFreeze{false};
+
     bool lowCutBypassed{false},
             peakBypassed{false},
             highCutBypassed{false},
@@ -156,86 +169,432 @@ struct ChainSettings {
             reverbFreezeMode{false};
 };
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState &apvts);
+ChainSettings getChainSettings(const ParameterHandles &parameters);
+
+/**
+ The settings the second channel of each pair (right or side) is filtered
+ with: chainSettings with its cut and peak settings replaced by the second
+ set, or chainSettings itself when the stereo mode is linked.
+ */
+ChainSettings getSecondSide(const ChainSettings &chainSettings);
 
-using Filter = juce::dsp::IIR::Filter<float>;
+bool lowCutSettingsChanged(const ChainSettings &a, const ChainSettings &b);
 
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+bool peakSettingsChanged(const ChainSettings &a, const ChainSettings &b);
 
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+bool highCutSettingsChanged(const ChainSettings &a, const ChainSettings &b);
+
+bool reverbSettingsChanged(const ChainSettings &a, const ChainSettings &b);
+
+/**
+ True when going from a to b changes the filter chains abruptly rather than
+ through the smoothers: the topology, design method or stereo mode, a
+ bypass, a slope, or a band switched on or off or to another type.
+ */
+bool switchesChains(const ChainSettings &a, const ChainSettings &b);
+
+/**
+ True when every stage is off or at its neutral setting (0 dB peak, cuts at
+ the ends of their range, no reverb, modulation or added latency), so
+ passing the input through unchanged is indistinguishable from processing it.
+ */
+bool isNeutral(const ChainSettings &chainSettings);
+
+/**
+ low cut, peak and high cut, built from either cascade type, followed by the
+ band bank. Both cascade types share the same interface, so everything that
+ configures or runs a chain works on either topology. The bank is made of
+ biquads in both.
+ */
+template<typename SampleType, template<typename, int> class CascadeType>
+using FilterChainOf = juce::dsp::ProcessorChain<CascadeType<SampleType, 4>,
+    CascadeType<SampleType, 1>,
+    CascadeType<SampleType, 4>,
+    BandBank<SampleType, numBands> >;
+
+template<typename SampleType>
+using FilterChain = FilterChainOf<SampleType, BiquadCascade>;
+
+template<typename SampleType>
+using SvfChain = FilterChainOf<SampleType, SvfCascade>;
+
+using CutFilter = BiquadCascade<float, 4>;
+
+using PeakFilter = BiquadCascade<float, 1>;
+
+using MonoChain = FilterChain<float>;
 
 
 enum ChainPositions {
     lowCut,
     peak,
     highCut,
-    reverb
+    bands
 };
 
 
-using Coefficients = Filter::CoefficientsPtr;
+template<typename Math = PreciseMath>
+BiquadCoefficients makePeakFilter(const ChainSettings &chainSettings, double sampleRate) {
+    const auto gainFactor = juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels);
+
+    if (chainSettings.designMethod == DesignMethod::Matched)
+        return makeMatchedPeakCoefficients<Math>(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality,
+                                                 gainFactor);
 
-void updateCoefficients(Coefficients &old, const Coefficients &replacements);
+    return makePeakCoefficients<Math>(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality, gainFactor);
+}
+
+template<typename Math = PreciseMath>
+SvfCoefficients makePeakFilterSvf(const ChainSettings &chainSettings, double sampleRate) {
+    if (chainSettings.designMethod == DesignMethod::Matched)
+        return makeSvfFromBiquad(makePeakFilter<Math>(chainSettings, sampleRate));
 
-Coefficients makePeakFilter(const ChainSettings &chainSettings, double sampleRate);
+    return makeSvfPeak<Math>(sampleRate,
+                             chainSettings.peakFreq,
+                             chainSettings.peakQuality,
+                             juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+}
 
 template<typename ChainType, typename CoefficientType>
+void updatePeakFilter(ChainType &chain, const CoefficientType &peakCoefficients) {
+    chain.setSection(0, peakCoefficients);
+    chain.setNumActiveStages(1);
+}
 
+template<typename ChainType, typename CoefficientType>
 void updateCutFilter(ChainType &chain, const CoefficientType &cutCoefficients, Slope cutSlope) {
-    chain.template setBypassed<0>(true);
-    chain.template setBypassed<1>(true);
-    chain.template setBypassed<2>(true);
-    chain.template setBypassed<3>(true);
-
-    switch (cutSlope) {
-        case Slope_12:
-            *chain.template get<0>().coefficients = *cutCoefficients[0];
-            chain.template setBypassed<0>(false);
-            break;
-        case Slope_24:
-            *chain.template get<0>().coefficients = *cutCoefficients[0];
-            chain.template setBypassed<0>(false);
-            *chain.template get<1>().coefficients = *cutCoefficients[1];
-            chain.template setBypassed<1>(false);
-            break;
-        case Slope_36:
-            *chain.template get<0>().coefficients = *cutCoefficients[0];
-            chain.template setBypassed<0>(false);
-            *chain.template get<1>().coefficients = *cutCoefficients[1];
-            chain.template setBypassed<1>(false);
-            *chain.template get<2>().coefficients = *cutCoefficients[2];
-            chain.template setBypassed<2>(false);
-            break;
-        case Slope_48:
-            *chain.template get<0>().coefficients = *cutCoefficients[0];
-            chain.template setBypassed<0>(false);
-            *chain.template get<1>().coefficients = *cutCoefficients[1];
-            chain.template setBypassed<1>(false);
-            *chain.template get<2>().coefficients = *cutCoefficients[2];
-            chain.template setBypassed<2>(false);
-            *chain.template get<3>().coefficients = *cutCoefficients[3];
-            chain.template setBypassed<3>(false);
-            break;
-        default: break;
+    const auto numStages = static_cast<int>(cutSlope) + 1;
+    jassert(numStages <= cutCoefficients.numSections);
+
+    for (int i = 0; i < numStages; ++i)
+        chain.setSection(i, cutCoefficients[i]);
+
+    chain.setNumActiveStages(numStages);
+}
+
+template<typename Math = PreciseMath>
+auto makeLowCutFilter(const ChainSettings &chainSettings, double sampleRate) {
+    const auto order = 2 * (chainSettings.lowCutSlope + 1);
+
+    if (chainSettings.designMethod == DesignMethod::Matched)
+        return designMatchedButterworthHighPass<CutFilter::maxStages, Math>(chainSettings.lowCutFreq, sampleRate,
+                                                                            order);
+
+    return designButterworthHighPass<CutFilter::maxStages, Math>(chainSettings.lowCutFreq, sampleRate, order);
+}
+
+template<typename Math = PreciseMath>
+auto makeHighCutFilter(const ChainSettings &chainSettings, double sampleRate) {
+    const auto order = 2 * (chainSettings.highCutSlope + 1);
+
+    if (chainSettings.designMethod == DesignMethod::Matched)
+        return designMatchedButterworthLowPass<CutFilter::maxStages, Math>(chainSettings.highCutFreq, sampleRate,
+                                                                           order);
+
+    return designButterworthLowPass<CutFilter::maxStages, Math>(chainSettings.highCutFreq, sampleRate, order);
+}
+
+template<typename Math = PreciseMath>
+auto makeLowCutFilterSvf(const ChainSettings &chainSettings, double sampleRate) {
+    if (chainSettings.designMethod == DesignMethod::Matched)
+        return makeSvfFromBiquads(makeLowCutFilter<Math>(chainSettings, sampleRate));
+
+    return designButterworthHighPassSvf<CutFilter::maxStages, Math>(chainSettings.lowCutFreq,
+                                                                    sampleRate,
+                                                                    2 * (chainSettings.lowCutSlope + 1));
+}
+
+template<typename Math = PreciseMath>
+auto makeHighCutFilterSvf(const ChainSettings &chainSettings, double sampleRate) {
+    if (chainSettings.designMethod == DesignMethod::Matched)
+        return makeSvfFromBiquads(makeHighCutFilter<Math>(chainSettings, sampleRate));
+
+    return designButterworthLowPassSvf<CutFilter::maxStages, Math>(chainSettings.highCutFreq,
+                                                                   sampleRate,
+                                                                   2 * (chainSettings.highCutSlope + 1));
+}
+
+/** The biquad of one band, with its frequency kept below Nyquist. */
+template<typename Math = PreciseMath>
+BiquadCoefficients makeBandFilter(const BandSettings &band, double sampleRate, DesignMethod designMethod) {
+    const auto frequency = juce::jmin((double) band.freq, 0.45 * sampleRate);
+    const auto gainFactor = juce::Decibels::decibelsToGain((double) band.gainInDecibels);
+    const auto matched = designMethod == DesignMethod::Matched;
+
+    // the shelves and the notch only have a bilinear design
+    switch (band.type) {
+        case BandType::LowShelf: return makeLowShelfCoefficients<Math>(sampleRate, frequency, band.quality, gainFactor);
+        case BandType::HighShelf: return makeHighShelfCoefficients<Math>(sampleRate, frequency, band.quality,
+                                                                         gainFactor);
+        case BandType::Notch: return makeNotchCoefficients<Math>(sampleRate, frequency, band.quality);
+        case BandType::LowCut: return matched
+                                          ? makeMatchedHighPassCoefficients<Math>(sampleRate, frequency, band.quality)
+                                          : makeHighPassCoefficients<Math>(sampleRate, frequency, band.quality);
+        case BandType::HighCut: return matched
+                                           ? makeMatchedLowPassCoefficients<Math>(sampleRate, frequency, band.quality)
+                                           : makeLowPassCoefficients<Math>(sampleRate, frequency, band.quality);
+        case BandType::Peak:
+        default: return matched
+                            ? makeMatchedPeakCoefficients<Math>(sampleRate, frequency, band.quality, gainFactor)
+                            : makePeakCoefficients<Math>(sampleRate, frequency, band.quality, gainFactor);
+    }
+}
+
+/**
+ Applies a cut design per side: first to the even lanes (left or mid), second
+ to the odd lanes (right or side). A side with fewer stages, or none when it
+ is bypassed, passes through the extra sections unchanged.
+ */
+template<typename ChainType, typename CoefficientType>
+void updateCutFilter(ChainType &chain, const CoefficientType &first, int firstStages,
+                     const CoefficientType &second, int secondStages) {
+    using Section = std::decay_t<decltype(first[0])>;
+    const auto numStages = juce::jmax(firstStages, secondStages);
+
+    for (int i = 0; i < numStages; ++i)
+        chain.setSection(i, i < firstStages ? first[i] : Section{}, i < secondStages ? second[i] : Section{});
+
+    chain.setNumActiveStages(numStages);
+}
+
+inline int getNumCutStages(Slope slope, bool bypassed) {
+    return bypassed ? 0 : static_cast<int>(slope) + 1;
+}
+
+/** Applies one cut design to the given position of every chain. */
+template<int Position, typename ChainArray, typename CoefficientType>
+void updateCutFilters(ChainArray &chains, const CoefficientType &cutCoefficients, Slope cutSlope, bool bypassed) {
+    for (auto &chain: chains) {
+        chain.template setBypassed<Position>(bypassed);
+        updateCutFilter(chain.template get<Position>(), cutCoefficients, cutSlope);
     }
 }
 
-inline auto makeLowCutFilter(const ChainSettings &chainSettings, double sampleRate) {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
-        sampleRate,
-        2 * (chainSettings.lowCutSlope + 1));
+/** Applies a cut design per side to the given position of every chain, see updateCutFilter. */
+template<int Position, typename ChainArray, typename CoefficientType>
+void updateCutFilters(ChainArray &chains, const CoefficientType &first, int firstStages,
+                      const CoefficientType &second, int secondStages) {
+    for (auto &chain: chains) {
+        chain.template setBypassed<Position>(false);
+        updateCutFilter(chain.template get<Position>(), first, firstStages, second, secondStages);
+    }
 }
 
-inline auto makeHighCutFilter(const ChainSettings &chainSettings, double sampleRate) {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
-        sampleRate,
-        2 * (chainSettings.highCutSlope + 1));
+/** Applies the peak design to every chain. */
+template<int Position, typename ChainArray, typename CoefficientType>
+void updatePeakFilters(ChainArray &chains, const CoefficientType &peakCoefficients, bool bypassed) {
+    for (auto &chain: chains) {
+        chain.template setBypassed<Position>(bypassed);
+        updatePeakFilter(chain.template get<Position>(), peakCoefficients);
+    }
 }
 
+/** Applies a peak design per side to every chain; a bypassed side passes through. */
+template<int Position, typename ChainArray, typename CoefficientType>
+void updatePeakFilters(ChainArray &chains, const CoefficientType &first, bool firstBypassed,
+                       const CoefficientType &second, bool secondBypassed) {
+    for (auto &chain: chains) {
+        chain.template setBypassed<Position>(false);
+        chain.template get<Position>().setSection(0, firstBypassed ? CoefficientType{} : first,
+                                                  secondBypassed ? CoefficientType{} : second);
+        chain.template get<Position>().setNumActiveStages(1);
+    }
+}
+
+/**
+ The filter state for one sample precision. Channels are processed in
+ groups, one channel per lane of a SIMD register, so a stereo (or 4/8
+ channel) bus runs through a single instruction stream: 4 channels per
+ register in float, 2 in double.
+ */
+template<typename SampleType, int MaxNumChannels>
+struct ChannelGroups {
+    using Vector = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr int numLanes = (int) Vector::size();
+    static constexpr int maxGroups = (MaxNumChannels + numLanes - 1) / numLanes;
+
+    std::array<FilterChain<Vector>, maxGroups> chains;
+    std::array<SvfChain<Vector>, maxGroups> svfChains;
+
+    // With multirate bass on, the low cut runs at sampleRate / factor in these
+    // bands instead of in the chains, as long as its frequency is low enough.
+    std::array<MultirateBand<Vector>, maxGroups> multirateBands;
+
+    // With mono bass on, this runs ahead of everything else in the group.
+    std::array<MonoMaker<Vector>, maxGroups> monoMakers;
+
+    // During a switch crossfade, copies of the chains as they were keep
+    // running here on a copy of the group's input, see holdChains. The
+    // second set holds what the first was fading from, when a switch comes
+    // in while a fade is still running.
+    struct HeldChains {
+        std::array<FilterChain<Vector>, maxGroups> chains;
+        std::array<SvfChain<Vector>, maxGroups> svfChains;
+    };
+
+    std::array<HeldChains, 2> held;
+
+    juce::HeapBlock<char> interleavedStorage, heldStorage;
+    juce::dsp::AudioBlock<Vector> interleavedBlock, heldBlock;
+
+    static int getNumGroups(int numChannels) { return (numChannels + numLanes - 1) / numLanes; }
+
+    /** The number of whole channel pairs in a group; numLanes is even, so pairs never straddle groups. */
+    static int getNumPairs(int group, int numChannels) {
+        return juce::jmin(numLanes, numChannels - group * numLanes) / 2;
+    }
+
+    void prepare(double sampleRate, int maximumBlockSize) {
+        juce::dsp::ProcessSpec spec;
+        spec.maximumBlockSize = (juce::uint32) maximumBlockSize;
+        spec.numChannels = 1;
+        spec.sampleRate = sampleRate;
+
+        for (auto &chain: chains)
+            chain.prepare(spec);
+
+        for (auto &chain: svfChains)
+            chain.prepare(spec);
+
+        for (auto &band: multirateBands)
+            band.prepare(sampleRate, maximumBlockSize);
+
+        for (auto &monoMaker: monoMakers)
+            monoMaker.prepare(spec);
+
+        interleavedBlock = juce::dsp::AudioBlock<Vector>(interleavedStorage, (size_t) maxGroups,
+                                                         (size_t) maximumBlockSize);
+        heldBlock = juce::dsp::AudioBlock<Vector>(heldStorage, held.size(), (size_t) maximumBlockSize);
+    }
+
+    /**
+     Copies the running chains of a topology, coefficients and state, into
+     the first held set. With keepFade, what the first set held moves to the
+     second one. The chains are plain arrays, so this doesn't allocate.
+     */
+    void holdChains(FilterTopology topology, bool keepFade) {
+        if (keepFade)
+            held[1] = held[0];
+
+        if (topology == FilterTopology::StateVariable)
+            held[0].svfChains = svfChains;
+        else
+            held[0].chains = chains;
+    }
+
+    void resetChains() {
+        resetChains(FilterTopology::Biquad);
+        resetChains(FilterTopology::StateVariable);
+
+        for (auto &set: held) {
+            for (auto &chain: set.chains)
+                chain.reset();
+
+            for (auto &chain: set.svfChains)
+                chain.reset();
+        }
+
+        for (auto &monoMaker: monoMakers)
+            monoMaker.reset();
+    }
+
+    /** Resets the chains of one topology only, leaving the held ones alone. */
+    void resetChains(FilterTopology topology) {
+        if (topology == FilterTopology::StateVariable) {
+            for (auto &chain: svfChains)
+                chain.reset();
+        } else {
+            for (auto &chain: chains)
+                chain.reset();
+        }
+    }
+
+    void resetMultirateBands() {
+        for (auto &band: multirateBands)
+            band.reset();
+    }
+
+    /**
+     Copies the channels into the lanes. With midSide, each pair of channels
+     is encoded on the way: mid in the even lane, side in the odd one.
+     */
+    void interleave(const juce::AudioBuffer<SampleType> &buffer, int numChannels, int numSamples, bool midSide) {
+        jassert(numSamples <= (int) interleavedBlock.getNumSamples());
+
+        const auto half = SampleType(0.5);
+
+        for (int group = 0; group * numLanes < numChannels; ++group) {
+            auto *frames = reinterpret_cast<SampleType *>(interleavedBlock.getChannelPointer((size_t) group));
+
+            for (int lane = 0; lane < numLanes; ++lane) {
+                const auto channel = group * numLanes + lane;
+
+                if (midSide && lane % 2 == 0 && channel + 1 < numChannels) {
+                    auto *left = buffer.getReadPointer(channel);
+                    auto *right = buffer.getReadPointer(channel + 1);
+
+                    for (int i = 0; i < numSamples; ++i) {
+                        frames[i * numLanes + lane] = half * (left[i] + right[i]);
+                        frames[i * numLanes + lane + 1] = half * (left[i] - right[i]);
+                    }
+
+                    ++lane;
+                } else if (channel < numChannels) {
+                    auto *source = buffer.getReadPointer(channel);
+                    for (int i = 0; i < numSamples; ++i)
+                        frames[i * numLanes + lane] = source[i];
+                } else {
+                    for (int i = 0; i < numSamples; ++i)
+                        frames[i * numLanes + lane] = SampleType(0);
+                }
+            }
+        }
+    }
+
+    /** The inverse of interleave, decoding mid and side back to left and right with midSide. */
+    void deinterleave(juce::AudioBuffer<SampleType> &buffer, int numChannels, int numSamples, bool midSide) const {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const auto group = channel / numLanes;
+            const auto lane = channel % numLanes;
+            auto *frames = reinterpret_cast<const SampleType *>(interleavedBlock.getChannelPointer((size_t) group));
+            auto *destination = buffer.getWritePointer(channel);
+
+            if (midSide && lane % 2 == 0 && channel + 1 < numChannels) {
+                auto *right = buffer.getWritePointer(channel + 1);
+
+                for (int i = 0; i < numSamples; ++i) {
+                    const auto mid = frames[i * numLanes + lane];
+                    const auto side = frames[i * numLanes + lane + 1];
+                    destination[i] = mid + side;
+                    right[i] = mid - side;
+                }
+
+                ++channel;
+                continue;
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = frames[i * numLanes + lane];
+        }
+    }
+};
+
+/** Configures a mono chain for display or analysis, with the precise designs. */
+void updateMonoChain(MonoChain &chain, const ChainSettings &chainSettings, double sampleRate);
+
+/** Magnitude of the bands of a mono chain that aren't bypassed. */
+double getMagnitudeForFrequency(const MonoChain &chain, double frequency, double sampleRate);
+
+class LinearPhaseEQ;
+
+class ConvolutionReverb;
+
 //==============================================================================
 /**
 */
-class BassQualizerAudioProcessor : public juce::AudioProcessor {
+class BassQualizerAudioProcessor : public juce::AudioProcessor,
+                                   private juce::AsyncUpdater {
 public:
     //==============================================================================
     BassQualizerAudioProcessor();
@@ -253,6 +612,10 @@ public:
 
     void processBlock(juce::AudioBuffer<float> &, juce::MidiBuffer &) override;
 
+    void processBlock(juce::AudioBuffer<double> &, juce::MidiBuffer &) override;
+
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
     //==============================================================================
     juce::AudioProcessorEditor *createEditor() override;
 
@@ -287,28 +650,304 @@ public:
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
-    juce::dsp::Reverb reverb;
+    static constexpr int maxNumChannels = 8;
+
+    /**
+     Loads an impulse response for the convolution reverb in the background
+     and remembers it in the plugin state. Call from the message thread.
+     */
+    void loadImpulseResponse(const juce::File &file);
+
+    juce::File getImpulseResponseFile() const;
 
     juce::AudioProcessorValueTreeState apvts{*this, nullptr, "Parameters", createParameters()};
 
-    using BlockType = juce::AudioBuffer<float>;
-    SingleChannelSampleFifo<BlockType> leftChannelFifo{Channel::Left};
-    SingleChannelSampleFifo<BlockType> rightChannelFifo{Channel::Right};
+    /** The processor's parameter lookups, for reading settings without going through ids. */
+    const ParameterHandles &getParameterHandles() const { return parameterHandles; }
+
+    // Raw samples of one channel for the analyzer, written once per block.
+    // The editor reads them in place; what doesn't fit while it is behind
+    // is dropped.
+    static constexpr int analyzerRingSize = 8192;
+    SampleRing leftChannelRing{analyzerRingSize};
+
+    // What goes in and what comes out, after auto gain. Written by the audio
+    // thread, read by the editor.
+    LevelMeter<maxNumChannels> inputMeter, outputMeter;
 
 private:
-    MonoChain leftChain, rightChain;
+    // Both precisions are always prepared; only the one the host currently
+    // uses is kept up to date and processed.
+    ChannelGroups<float, maxNumChannels> floatGroups;
+    ChannelGroups<double, maxNumChannels> doubleGroups;
+
+    /** Calls function with the channel groups of the precision in use. */
+    template<typename Function>
+    void forActiveGroups(Function &&function) {
+        if (isUsingDoublePrecision())
+            function(doubleGroups);
+        else
+            function(floatGroups);
+    }
+
+    template<typename SampleType>
+    auto &getGroups() {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleGroups;
+        else
+            return floatGroups;
+    }
+
+    template<typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType> &buffer);
+
+    // Everything is allocated for blocks of up to this many samples; longer
+    // host blocks are processed as slices of it.
+    int preparedBlockSize = 0;
+
+    template<typename SampleType>
+    void processSlice(juce::AudioBuffer<SampleType> &buffer);
+
+    template<typename SampleType>
+    void processStages(juce::AudioBuffer<SampleType> &buffer, int numChannels);
+
+    template<typename Groups>
+    void processChannelGroups(Groups &groups, int numChannels, int numSamples);
+
+    // Switches (see switchesChains) and loaded states crossfade from the
+    // chains as they were to the new ones over switchFadeSeconds, with equal
+    // power gains. The held chains only run while a fade is in progress.
+    // Coming from skipped filters, the fade starts from the dry signal.
+    // A switch during a fade fades out of the mix that is playing: the fade
+    // that was running carries on in the held chains (heldFadeRemaining),
+    // from the first held set to the second. A switch during that one waits
+    // for it to finish.
+    static constexpr double switchFadeSeconds = 0.02;
+    std::vector<float> switchFadeGains;
+    int switchFadeRemaining = 0, heldFadeRemaining = 0;
+    std::array<bool, 2> fadeFromDry{};
+    std::array<FilterTopology, 2> fadeTopology{};
+    std::atomic<bool> stateLoaded{false};
+
+    void beginSwitchFade();
+
+    void cancelSwitchFade();
+
+    template<typename Groups>
+    void processHeldChains(Groups &groups, int group, int set,
+                           juce::dsp::AudioBlock<typename Groups::Vector> &block);
+
+    template<typename Vector>
+    void mixSwitchFade(juce::dsp::AudioBlock<Vector> &block, const juce::dsp::AudioBlock<Vector> &held,
+                       int remaining) const;
+
+    // juce::dsp::Reverb and FdnReverb keep separate state for (at most) two
+    // channels, so wider buses run one reverb per pair of channels. FdnReverb
+    // runs in the host's precision, so like the groups there is one set each.
+    std::array<juce::dsp::Reverb, (maxNumChannels + 1) / 2> reverbs;
+
+    template<typename SampleType>
+    using FdnReverbs = std::array<FdnReverb<SampleType>, (maxNumChannels + 1) / 2>;
+
+    FdnReverbs<float> floatFdnReverbs;
+    FdnReverbs<double> doubleFdnReverbs;
+
+    template<typename SampleType>
+    auto &getFdnReverbs() {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleFdnReverbs;
+        else
+            return floatFdnReverbs;
+    }
+
+    /** Calls function with every FdnReverb of both precisions. */
+    template<typename Function>
+    void forEachFdnReverb(Function &&function) {
+        for (auto &reverb: floatFdnReverbs)
+            function(reverb);
+
+        for (auto &reverb: doubleFdnReverbs)
+            function(reverb);
+    }
+
+    // With the wet level at zero the reverb is just its dry gain, which
+    // juce::Reverb scales by reverbDryScale. reverbDryGain is the gain last
+    // applied, so changes ramp like they do inside the reverb.
+    static constexpr float reverbDryScale = 2.0f;
+    float reverbDryGain = 1.0f;
+    bool reverbSkipped = false;
+
+    // The convolution engine takes the same wet scaling as juce::Reverb at
+    // full width.
+    static constexpr float reverbWetScale = 3.0f;
+    std::unique_ptr<ConvolutionReverb> convolutionReverb;
+
+    template<typename SampleType>
+    void processReverb(juce::AudioBuffer<SampleType> &buffer, int numChannels);
+
+    template<typename Reverbs, typename SampleType>
+    void processReverbPairs(Reverbs &pairReverbs, juce::dsp::AudioBlock<SampleType> &block);
+
+    // Auto gain: the output is brought to the K-weighted loudness of the
+    // input. While frozen nothing is measured and the last gain is kept.
+    LoudnessMatch<maxNumChannels> loudnessMatch;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> autoGainSmoother;
+    static constexpr double autoGainRampSeconds = 0.2;
+
+    template<typename SampleType>
+    void applyAutoGain(juce::AudioBuffer<SampleType> &buffer, int numChannels);
+
+    // juce::dsp::Reverb, the convolution reverb and the linear phase EQ only
+    // run in float; in double precision they go through this buffer, sized in
+    // prepareToPlay.
+    juce::AudioBuffer<float> floatScratch;
+
+    template<typename SampleType, typename Function>
+    void processInFloat(juce::AudioBuffer<SampleType> &buffer, int numChannels, Function &&function);
 
+    bool lowCutMultirate = false;
+
+    bool usesMultirateBands() const;
+
+    bool shouldRunLowCutMultirate(const ChainSettings &chainSettings) const;
+
+    template<typename Math = PreciseMath>
     void updatePeakFilter(const ChainSettings &chainSettings);
 
+    // Dynamic peak: the detector runs over each block before the filters, and
+    // every control tick turns its envelope into a gain offset for the peak.
+    // Gain-only changes are redesigned from the cached frequency terms.
+    PeakDynamics peakDynamics;
+    float peakDynamicGain = 0.0f, designedPeakDynamicGain = 0.0f;
+    std::array<PeakPrototype, 2> peakPrototypes;
+    std::array<double, 2> peakSvfCutoffs{};
+
+    template<typename Math = PreciseMath>
+    void updatePeakGain(const ChainSettings &chainSettings);
+
+    static bool usesPeakDynamics(const ChainSettings &chainSettings);
+
+    template<typename SampleType>
+    void analysePeakLevel(juce::AudioBuffer<SampleType> &buffer, int numChannels);
+
     void updateFilters();
 
+    ParameterHandles parameterHandles{apvts};
+    ChainSettings lastChainSettings;
+    std::atomic<bool> forceFilterUpdate{true};
+
+    // Continuous filter parameters are ramped and the affected bands are
+    // redesigned once per control block instead of once per host block.
+    // Control blocks run on their own clock, independent of the host block
+    // size; with audio rate modulation they shrink to audioRateBlockSize.
+    static constexpr int controlBlockSize = 32;
+    static constexpr int audioRateBlockSize = 4;
+    int samplesUntilControlTick = 0;
+
+    // A ramping cut is only advanced and redesigned every cutRedesignTicks
+    // control blocks (128 samples): its smoothers and its sections cost
+    // several times what the peak's do.
+    static constexpr int cutRedesignTicks = 4;
+    int cutTicksUntilRedesign = 0, cutSamplesPending = 0;
+
+    int getControlBlockSize() const;
+    static constexpr double smoothingTimeSeconds = 0.05;
+
+    using FrequencySmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+
+    // one set per side, see getSecondSide; in linked mode both follow the
+    // same targets
+    struct SideSmoothers {
+        FrequencySmoother lowCutFreq, highCutFreq, peakFreq, peakQuality;
+        juce::SmoothedValue<float> peakGain;
+
+        void reset(double sampleRate, double rampLengthInSeconds);
+
+        void setTargets(const ChainSettings &side, bool jumpToTarget);
+
+        void skipCuts(int numSamples);
+
+        void skipPeak(int numSamples);
+
+        bool isPeakSmoothing() const;
+
+        bool isSmoothing() const;
+    };
+
+    std::array<SideSmoothers, 2> sideSmoothers;
+
+    void setSmootherTargets(const ChainSettings &chainSettings, bool jumpToTarget);
+
+    ChainSettings getSmoothedSettings(ChainSettings chainSettings) const;
+
+    void updateSmoothedFilters(int numSamples);
+
+    template<typename Math = PreciseMath>
     void updateLowCutFilter(const ChainSettings &chainSettings);
 
+    template<typename Math = PreciseMath>
     void updateHighCutFilter(const ChainSettings &chainSettings);
 
     void updateReverbFilter(const ChainSettings &chainSettings);
 
+    // Each band ramps its own frequency, gain and Q. Switching a band on or
+    // off, or changing its type, takes effect at once.
+    struct BandSmoothers {
+        FrequencySmoother freq, quality;
+        juce::SmoothedValue<float> gain;
+    };
+
+    std::array<BandSmoothers, numBands> bandSmoothers;
+
+    template<typename Math = PreciseMath>
+    void updateBand(int band, const ChainSettings &chainSettings);
+
+    FrequencySmoother monoBassFreqSmoother;
+
+    template<typename Math = PreciseMath>
+    void updateMonoBass(const ChainSettings &chainSettings);
+
+    // The LFO runs at sampleRate / audioRateBlockSize and is advanced once
+    // per control block, so it costs one waveform evaluation per 4 samples
+    // at most.
     juce::dsp::Oscillator<float> osc;
+    float lfoValue = 0.0f;
+
+    void advanceLfo(int numSamples);
+
+    void applyModulation(ChainSettings &chainSettings) const;
+
+    // Neutral settings skip the filters altogether. Silent input is processed
+    // until the tails have rung out, then the processor idles and outputs
+    // silence until the input comes back.
+    static constexpr float silenceThreshold = 1.0e-5f;
+
+    bool neutral = false, filtersSkipped = false, idle = false;
+    juce::int64 silentSamples = 0;
+    std::atomic<double> tailLengthSeconds{0.0};
+
+    bool isSmoothing() const;
+
+    double computeTailLengthSeconds(const ChainSettings &chainSettings) const;
+
+    template<typename SampleType>
+    static bool isSilent(const juce::AudioBuffer<SampleType> &buffer, int numChannels, int numSamples);
+
+    void resetProcessingState();
+
+    // Linear phase mode replaces the chains with one long FIR. Its kernel is
+    // redesigned in the background, so a redesign that couldn't be handed
+    // over yet stays pending until the next block.
+    std::unique_ptr<LinearPhaseEQ> linearPhaseEQ;
+    bool linearPhaseUpdatePending = false;
+
+    // The host is told about latency changes from the message thread, which
+    // also wakes the linear phase designer for settings handed over to it.
+    std::atomic<int> pendingLatency{0};
+
+    void updateLatency();
+
+    void handleAsyncUpdate() override;
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BassQualizerAudioProcessor)
 };
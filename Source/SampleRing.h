@@ -0,0 +1,91 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+/**
+ Lock-free ring of float samples between one producer (the audio thread)
+ and one consumer (the analyzer).
+
+ The producer appends whole blocks with at most two copies. The consumer
+ reads in place: getReadable hands out the ready samples as at most two
+ spans into the ring, and release gives them back once they have been
+ used. The positions only ever grow and are wrapped with a mask, so a full
+ ring can't be mistaken for an empty one.
+
+ All memory is allocated by the constructor; its size is the capacity,
+ whatever the block sizes on either side.
+ */
+class SampleRing {
+public:
+    struct Span {
+        const float *data = nullptr;
+        int size = 0;
+    };
+
+    /** The ready samples, oldest first: first, then second (which may be empty). */
+    struct Readable {
+        Span first, second;
+
+        int size() const noexcept { return first.size + second.size; }
+    };
+
+    /** The capacity is rounded up to a power of two. */
+    explicit SampleRing(int minimumCapacity)
+        : buffer((size_t) juce::nextPowerOfTwo(minimumCapacity), 0.0f),
+          mask((juce::uint32) buffer.size() - 1) {
+    }
+
+    int getCapacity() const noexcept { return (int) buffer.size(); }
+
+    /** Producer: appends what fits and drops the rest. Returns the number written. */
+    template<typename SampleType>
+    int write(const SampleType *samples, int numSamples) noexcept {
+        const auto write = writePosition.load(std::memory_order_relaxed);
+        const auto read = readPosition.load(std::memory_order_acquire);
+        const auto numToWrite = juce::jmin(numSamples, getCapacity() - (int) (write - read));
+        const auto start = (int) (write & mask);
+        const auto firstPart = juce::jmin(numToWrite, getCapacity() - start);
+
+        copy(samples, buffer.data() + start, firstPart);
+        copy(samples + firstPart, buffer.data(), numToWrite - firstPart);
+
+        writePosition.store(write + (juce::uint32) numToWrite, std::memory_order_release);
+        return numToWrite;
+    }
+
+    /** Consumer: views of the ready samples, valid until they are released. */
+    Readable getReadable() const noexcept {
+        const auto read = readPosition.load(std::memory_order_relaxed);
+        const auto ready = (int) (writePosition.load(std::memory_order_acquire) - read);
+        const auto start = (int) (read & mask);
+        const auto firstPart = juce::jmin(ready, getCapacity() - start);
+
+        return {{buffer.data() + start, firstPart}, {buffer.data(), ready - firstPart}};
+    }
+
+    /** Consumer: hands the oldest numSamples ready samples back to the producer. */
+    void release(int numSamples) noexcept {
+        const auto read = readPosition.load(std::memory_order_relaxed);
+        jassert(numSamples <= (int) (writePosition.load(std::memory_order_acquire) - read));
+
+        readPosition.store(read + (juce::uint32) numSamples, std::memory_order_release);
+    }
+
+private:
+    template<typename SampleType>
+    static void copy(const SampleType *source, float *destination, int numSamples) noexcept {
+        if constexpr (std::is_same_v<SampleType, float>) {
+            if (numSamples > 0)
+                std::memcpy(destination, source, sizeof(float) * (size_t) numSamples);
+        } else {
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (float) source[i];
+        }
+    }
+
+    std::vector<float> buffer;
+    const juce::uint32 mask;
+
+    std::atomic<juce::uint32> writePosition{0}, readPosition{0};
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include "BiquadCascade.h"
+
+/**
+ One trapezoidal (TPT) state variable filter section. The integrator states
+ ic1eq/ic2eq track the signal itself rather than a mix of past inputs and
+ outputs, so they stay meaningful when the coefficients change, and low
+ cutoffs don't suffer from the coefficient quantisation of a direct form.
+ */
+template<typename SampleType>
+struct alignas(16) SvfSection {
+    SampleType a1, a2, a3, m0, m1, m2;
+    SampleType ic1eq, ic2eq;
+};
+
+/**
+ A cascade of up to MaxStages state variable sections with the same interface
+ as BiquadCascade, so either can be dropped into a FilterChain.
+ */
+template<typename SampleType, int MaxStages>
+class SvfCascade {
+public:
+    static constexpr int maxStages = MaxStages;
+
+    SvfCascade() {
+        for (int i = 0; i < MaxStages; ++i)
+            setSection(i, SvfCoefficients{});
+
+        reset();
+    }
+
+    void prepare(const juce::dsp::ProcessSpec &spec) {
+        jassert(spec.numChannels == 1);
+        juce::ignoreUnused(spec);
+        reset();
+    }
+
+    void reset() {
+        for (auto &section: sections)
+            section.ic1eq = section.ic2eq = broadcast<SampleType>(0);
+    }
+
+    void setSection(int index, const SvfCoefficients &coefficients) noexcept {
+        jassert(juce::isPositiveAndBelow(index, MaxStages));
+
+        const auto gains = Gains::of(coefficients);
+
+        auto &section = sections[(size_t) index];
+        section.a1 = broadcast<SampleType>(gains.a1);
+        section.a2 = broadcast<SampleType>(gains.a2);
+        section.a3 = broadcast<SampleType>(gains.a3);
+        section.m0 = broadcast<SampleType>(coefficients.m0);
+        section.m1 = broadcast<SampleType>(coefficients.m1);
+        section.m2 = broadcast<SampleType>(coefficients.m2);
+
+        designs[(size_t) index] = coefficients;
+    }
+
+    /**
+     Sets a section to first in the even lanes and second in the odd ones.
+     The magnitude response follows first.
+     */
+    void setSection(int index, const SvfCoefficients &first, const SvfCoefficients &second) noexcept {
+        jassert(juce::isPositiveAndBelow(index, MaxStages));
+
+        const auto firstGains = Gains::of(first);
+        const auto secondGains = Gains::of(second);
+
+        auto &section = sections[(size_t) index];
+        section.a1 = broadcastPair<SampleType>(firstGains.a1, secondGains.a1);
+        section.a2 = broadcastPair<SampleType>(firstGains.a2, secondGains.a2);
+        section.a3 = broadcastPair<SampleType>(firstGains.a3, secondGains.a3);
+        section.m0 = broadcastPair<SampleType>(first.m0, second.m0);
+        section.m1 = broadcastPair<SampleType>(first.m1, second.m1);
+        section.m2 = broadcastPair<SampleType>(first.m2, second.m2);
+
+        designs[(size_t) index] = first;
+    }
+
+    void setNumActiveStages(int newNumStages) noexcept {
+        jassert(newNumStages >= 0 && newNumStages <= MaxStages);
+
+        for (auto i = numActiveStages; i < newNumStages; ++i)
+            sections[(size_t) i].ic1eq = sections[(size_t) i].ic2eq = broadcast<SampleType>(0);
+
+        numActiveStages = newNumStages;
+    }
+
+    int getNumActiveStages() const { return numActiveStages; }
+
+    /** Magnitude of the active sections at the given frequency. */
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const {
+        const auto warped = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+
+        double magnitude = 1.0;
+
+        for (int i = 0; i < numActiveStages; ++i) {
+            const auto &c = designs[(size_t) i];
+            const auto s = std::complex<double>(0.0, warped / c.g);
+            const auto response = c.m0 + (c.m1 * s + c.m2) / (s * s + c.k * s + 1.0);
+            magnitude *= std::abs(response);
+        }
+
+        return magnitude;
+    }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext &context) noexcept {
+        const auto &inputBlock = context.getInputBlock();
+        auto &outputBlock = context.getOutputBlock();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert(inputBlock.getNumChannels() == 1);
+        jassert(outputBlock.getNumChannels() == 1);
+        jassert(inputBlock.getNumSamples() == numSamples);
+
+        if (context.isBypassed || numActiveStages == 0) {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom(inputBlock);
+
+            return;
+        }
+
+        auto *input = inputBlock.getChannelPointer(0);
+        auto *output = outputBlock.getChannelPointer(0);
+
+        // only the stage counts the cascade has are instantiated
+        switch (numActiveStages) {
+            case 1: processStages<1>(input, output, numSamples);
+                break;
+            case 2: if constexpr (MaxStages >= 2) processStages<2>(input, output, numSamples);
+                break;
+            case 3: if constexpr (MaxStages >= 3) processStages<3>(input, output, numSamples);
+                break;
+            case 4: if constexpr (MaxStages >= 4) processStages<4>(input, output, numSamples);
+                break;
+            default: jassertfalse;
+                break;
+        }
+    }
+
+private:
+    /** The integrator gains of a section. */
+    struct Gains {
+        double a1, a2, a3;
+
+        static Gains of(const SvfCoefficients &coefficients) {
+            const auto a1 = 1.0 / (1.0 + coefficients.g * (coefficients.g + coefficients.k));
+            const auto a2 = coefficients.g * a1;
+            return {a1, a2, coefficients.g * a2};
+        }
+    };
+
+    template<int NumStages>
+    void processStages(const SampleType *input, SampleType *output, size_t numSamples) noexcept {
+        static_assert(NumStages <= MaxStages, "cascade does not have that many sections");
+
+        alignas(16) SvfSection<SampleType> local[NumStages];
+        for (int s = 0; s < NumStages; ++s)
+            local[s] = sections[(size_t) s];
+
+        const auto two = broadcast<SampleType>(2);
+
+        for (size_t i = 0; i < numSamples; ++i) {
+            auto x = input[i];
+
+            for (int s = 0; s < NumStages; ++s) {
+                auto &section = local[s];
+                const auto v3 = x - section.ic2eq;
+                const auto v1 = section.a1 * section.ic1eq + section.a2 * v3;
+                const auto v2 = section.ic2eq + section.a2 * section.ic1eq + section.a3 * v3;
+                section.ic1eq = two * v1 - section.ic1eq;
+                section.ic2eq = two * v2 - section.ic2eq;
+                x = section.m0 * x + section.m1 * v1 + section.m2 * v2;
+            }
+
+            output[i] = x;
+        }
+
+        for (int s = 0; s < NumStages; ++s) {
+            juce::dsp::util::snapToZero(local[s].ic1eq);
+            juce::dsp::util::snapToZero(local[s].ic2eq);
+            sections[(size_t) s].ic1eq = local[s].ic1eq;
+            sections[(size_t) s].ic2eq = local[s].ic2eq;
+        }
+    }
+
+    std::array<SvfSection<SampleType>, MaxStages> sections;
+    std::array<SvfCoefficients, MaxStages> designs;
+    int numActiveStages = 0;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+/**
+ Hands the newest of a stream of values from one writer thread to one
+ reader thread, without locks and without queueing.
+
+ The writer fills its back buffer and publishes it; the reader takes the
+ newest published buffer when it gets round to it, so anything published
+ in between is simply dropped. Each side keeps its buffer to itself until
+ it swaps, so neither ever sees the other one working.
+ */
+template<typename T>
+class TripleBuffer {
+public:
+    /** Writer: the buffer to fill. */
+    T &getWriteBuffer() noexcept { return buffers[(size_t) writeIndex]; }
+
+    /** Writer: makes the write buffer the newest, replacing any the reader hasn't taken. */
+    void publish() noexcept {
+        writeIndex = middle.exchange(writeIndex | freshFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /** Reader: swaps in the newest buffer. False when nothing was published since the last fetch. */
+    bool fetch() noexcept {
+        if ((middle.load(std::memory_order_relaxed) & freshFlag) == 0)
+            return false;
+
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    /** Reader: the buffer taken by the last fetch. */
+    const T &getReadBuffer() const noexcept { return buffers[(size_t) readIndex]; }
+
+private:
+    static constexpr int indexMask = 3, freshFlag = 4;
+
+    std::array<T, 3> buffers;
+    int writeIndex = 0, readIndex = 1;
+    std::atomic<int> middle{2};
+};